@@ -51,33 +51,151 @@
 
 #include <Arduino.h>
 #include <ConfigurableFirmata.h>
+#include <FirmataFeature.h>
+#include <Encoder7Bit.h>
 #include <stdint.h>
 
 #include "Photoresistor.h"
+#include "PlacementInference.h"
+#include <TimingStats.h>
 
+/// <summary>
+/// Arrangement grid driver. Lasers cross the grid along its rows and columns,
+/// a ship that is placed on the grid breaks the beams it covers. Each sample
+/// reports the beams that have been broken since the previous one.
+/// The timing of the sampling is monitored and can be queried with the
+/// TIMING_MESSAGE. The remote computer may opt in to the PLACEMENT_MESSAGE,
+/// which reports the tiles covered by ships instead of single beams.
+/// </summary>
 template<
 	typename LaserPhotoresistorArrayRow,
 	typename LaserPhotoresistorArrayColumn,
-	byte MAX_ROWS = 8, byte MAX_COLUMNS = 8
+	byte MAX_ROWS = 8, byte MAX_COLUMNS = 8,
+	uint16_t SAMPLE_RATE = 10
 >
-class ArrangeGrid {
+class ArrangeGrid : public FirmataFeature {
+
+public:
+	// A beam has been broken: 0xF0 0x0D row 0xF7 or 0xF0 0x0C column 0xF7
+	static const byte ROW_CHANGE_MESSAGE     = 0x0D;
+	static const byte COLUMN_CHANGE_MESSAGE  = 0x0C;
+	// A beam has been restored: 0xF0 0x02 row 0xF7 or 0xF0 0x01 column 0xF7
+	static const byte ROW_RESTORE_MESSAGE    = 0x02;
+	static const byte COLUMN_RESTORE_MESSAGE = 0x01;
+
+	/// <summary>
+	/// Query the logic levels of all beams, e.g. after the remote computer
+	/// reconnected:
+	/// 0xF0 0x03 0xF7
+	/// The reply holds the masks of the broken rows and columns, both bytes
+	/// 7-bit encoded:
+	/// 0xF0 0x03 rowMask columnMask 0xF7
+	/// </summary>
+	static const byte BEAM_STATE_MESSAGE = 0x03;
+
+	/// <summary>
+	/// Timings kept by the monitor.
+	/// </summary>
+	enum Timing {
+		// Time between two samples beyond the nominal sample period.
+		TIMING_SAMPLE_PERIOD,
+		// Time a sample takes.
+		TIMING_RUN,
+		// Worst case time from a beam break until the last byte of its change
+		// message is on the wire, beyond the nominal sample period. The beam
+		// may have been broken right after the previous sample.
+		TIMING_LATENCY,
+		MAX_TIMINGS
+	};
+
+	/// <summary>
+	/// Query the statistics of a timing:
+	/// 0xF0 0x05 timing [flags] 0xF7
+	/// The reply holds the nominal sample period in ms followed by count,
+	/// min, max and average in us and the histogram, each as 16-bit value
+	/// LSB first and 7-bit encoded:
+	/// 0xF0 0x05 timing period stats... 0xF7
+	/// </summary>
+	static const byte TIMING_MESSAGE = 0x05;
+	enum TimingFlags {
+		TIMING_RESET = 0x01, // Reset the timing once it has been reported.
+	};
+
+	/// <summary>
+	/// Set the placement flags and query the placement:
+	/// 0xF0 0x04 flags 0xF7
+	/// The reply holds the masks of the blocked rows and columns followed by
+	/// a mask of columns per row for the occupied and for the ambiguous
+	/// tiles, see PlacementInference, each byte 7-bit encoded:
+	/// 0xF0 0x04 rowMask columnMask occupied... ambiguous... 0xF7
+	/// It is also sent after each sample that changed the blocked beams if
+	/// the remote computer opted in to it.
+	/// </summary>
+	static const byte PLACEMENT_MESSAGE = 0x04;
+	enum PlacementFlags {
+		// Report the placement on change instead of the change and restore
+		// messages of single beams. Disabled after a reset.
+		PLACEMENT_REPORT = 0x01,
+	};
+
+	/// <summary>
+	/// Time between two samples, see run().
+	/// </summary>
+	enum : uint32_t {
+		SAMPLE_PERIOD_MICROS = 1000000UL / SAMPLE_RATE,
+	};
+
+private:
+
+	enum {
+		SAMPLE_PERIOD_MILLIS = 1000 / SAMPLE_RATE,
+		// Bits per byte on the wire with start and stop bit.
+		SERIAL_BITS_PER_BYTE = 10,
+		MAX_CHANNELS         = MAX_ROWS > MAX_COLUMNS ? MAX_ROWS : MAX_COLUMNS,
+	};
+
+	static_assert(SAMPLE_PERIOD_MILLIS >= 1 && SAMPLE_PERIOD_MILLIS <= 0x7F,
+		"The sample period is reported as 7-bit value in ms.");
+	static_assert(LaserPhotoresistorArrayRow::read10Micros()
+		+ LaserPhotoresistorArrayColumn::read10Micros()
+		<= SAMPLE_PERIOD_MICROS / 4,
+		"Sampling takes more than a quarter of the time, lower the "
+		"SAMPLE_RATE or raise F_SCK of the laser arrays.");
 
 	struct OnSignalEdgeListenerRow :
 			public Photoresistor::OnSignalEdgeListener {
 		virtual ~OnSignalEdgeListenerRow() { }
 		virtual void onRaisingSignalEdge(uint8_t position) {
-			sendRowChangeMessage(position);
+			onBeamBroken();
+			placement.setRowBlocked(position, true);
+			if (!isPlacementReported) {
+				sendBeamMessage(ROW_CHANGE_MESSAGE, position % MAX_ROWS);
+			}
+		}
+		virtual void onFallingSignalEdge(uint8_t position) {
+			placement.setRowBlocked(position, false);
+			if (!isPlacementReported) {
+				sendBeamMessage(ROW_RESTORE_MESSAGE, position % MAX_ROWS);
+			}
 		}
-		virtual void onFallingSignalEdge(uint8_t position) { /* Not used. */ }
 	};
 
 	struct OnSignalEdgeListenerColumn :
 		public Photoresistor::OnSignalEdgeListener {
 		virtual ~OnSignalEdgeListenerColumn() { }
 		virtual void onRaisingSignalEdge(uint8_t position) {
-			sendColumnChangeMessage(position);
+			onBeamBroken();
+			placement.setColumnBlocked(position, true);
+			if (!isPlacementReported) {
+				sendBeamMessage(COLUMN_CHANGE_MESSAGE, position % MAX_COLUMNS);
+			}
+		}
+		virtual void onFallingSignalEdge(uint8_t position) {
+			placement.setColumnBlocked(position, false);
+			if (!isPlacementReported) {
+				sendBeamMessage(COLUMN_RESTORE_MESSAGE, position % MAX_COLUMNS);
+			}
 		}
-		virtual void onFallingSignalEdge(uint8_t position) { /* Not used. */ }
 	};
 
 	static LaserPhotoresistorArrayRow laserPhotoresistorArrayRow;
@@ -86,27 +204,108 @@ class ArrangeGrid {
 	static Photoresistor photoresistorColumn[MAX_COLUMNS];
 	static OnSignalEdgeListenerRow onSignalEdgeListenerRow;
 	static OnSignalEdgeListenerColumn onSignalEdgeListenerColumn;
+	static TimingStats timingStats[MAX_TIMINGS];
+	static PlacementInference<MAX_ROWS, MAX_COLUMNS> placement;
+	static bool isPlacementReported;
+	// Start of the last sample, if there has been one.
+	static unsigned long tSampleMicros;
+	static bool hasSampled;
+	// Earliest time the beams reported by the running sample have been broken.
+	static unsigned long tSampleBreakMicros;
+	// Earliest break of the changes that have not been flushed yet.
+	static unsigned long tPendingBreakMicros;
+	static bool hasPendingBreak;
+
+	static void onBeamBroken() {
+		if (!hasPendingBreak) {
+			tPendingBreakMicros = tSampleBreakMicros;
+			hasPendingBreak = true;
+		}
+	}
+
+	/// <summary>
+	/// Add a duration that is at least the nominal sample period. Only what
+	/// exceeds it is kept, such that it fits 16-bit.
+	/// </summary>
+	static void addBeyondSamplePeriod(Timing timing, unsigned long micros) {
+		unsigned long beyond = 0;
+		if (micros > SAMPLE_PERIOD_MICROS) {
+			beyond = micros - SAMPLE_PERIOD_MICROS;
+		}
+		timingStats[timing].add(beyond < UINT16_MAX ? beyond : UINT16_MAX);
+	}
 
-	static const byte ROW_CHANGE_MESSAGE    = 0x0D;
-	static const byte COLUMN_CHANGE_MESSAGE = 0x0C;
+	static void sendTimingReply(byte timing, bool reset) {
+		const TimingStats & stats = timingStats[timing];
+		const uint16_t summary[] = {
+			stats.getCount(),
+			stats.getMinMicros(),
+			stats.getMaxMicros(),
+			stats.getAverageMicros()
+		};
+		Firmata.write(START_SYSEX);
+		Firmata.write(TIMING_MESSAGE);
+		Firmata.write(timing);
+		Firmata.write(SAMPLE_PERIOD_MILLIS);
+		Encoder7Bit.startBinaryWrite();
+		for (uint8_t i = 0; i < sizeof(summary) / sizeof(summary[0]); i++) {
+			Encoder7Bit.writeBinary(summary[i] & 0xFF);
+			Encoder7Bit.writeBinary(summary[i] >> 8);
+		}
+		for (uint8_t i = 0; i < TimingStats::HISTOGRAM_BUCKETS; i++) {
+			Encoder7Bit.writeBinary(stats.getHistogram(i) & 0xFF);
+			Encoder7Bit.writeBinary(stats.getHistogram(i) >> 8);
+		}
+		Encoder7Bit.endBinaryWrite();
+		Firmata.write(END_SYSEX);
+		if (reset) {
+			timingStats[timing].reset();
+		}
+	}
+
+	/// <summary>
+	/// Report the inferred placement back to the remote computer.
+	/// </summary>
+	static void sendPlacementMessage() {
+		uint8_t occupied[MAX_ROWS];
+		uint8_t ambiguous[MAX_ROWS];
+		placement.infer(occupied, ambiguous);
+		Firmata.write(START_SYSEX);
+		Firmata.write(PLACEMENT_MESSAGE);
+		Encoder7Bit.startBinaryWrite();
+		Encoder7Bit.writeBinary(placement.getRowMask());
+		Encoder7Bit.writeBinary(placement.getColumnMask());
+		for (uint8_t i = 0; i < MAX_ROWS; i++) {
+			Encoder7Bit.writeBinary(occupied[i]);
+		}
+		for (uint8_t i = 0; i < MAX_ROWS; i++) {
+			Encoder7Bit.writeBinary(ambiguous[i]);
+		}
+		Encoder7Bit.endBinaryWrite();
+		Firmata.write(END_SYSEX);
+	}
 
 	/// <summary>
-	/// Report row change message back to the remote computer.
+	/// Report a change or restore message of a beam back to the remote
+	/// computer.
 	/// </summary>
-	static void sendRowChangeMessage(byte position) {
+	static void sendBeamMessage(byte command, byte position) {
 		Firmata.write(START_SYSEX);
-		Firmata.write(ROW_CHANGE_MESSAGE);
-		Firmata.write(position % MAX_ROWS);
+		Firmata.write(command);
+		Firmata.write(position);
 		Firmata.write(END_SYSEX);
 	}
 
 	/// <summary>
-	/// Report column change message back to the remote computer.
+	/// Report the logic levels of all beams back to the remote computer.
 	/// </summary>
-	static void sendColumnChangeMessage(byte position) {
+	static void sendBeamStateMessage() {
 		Firmata.write(START_SYSEX);
-		Firmata.write(COLUMN_CHANGE_MESSAGE);
-		Firmata.write(position % MAX_COLUMNS);
+		Firmata.write(BEAM_STATE_MESSAGE);
+		Encoder7Bit.startBinaryWrite();
+		Encoder7Bit.writeBinary(placement.getRowMask());
+		Encoder7Bit.writeBinary(placement.getColumnMask());
+		Encoder7Bit.endBinaryWrite();
 		Firmata.write(END_SYSEX);
 	}
 
@@ -125,23 +324,108 @@ public:
 		}
 	}
 
+	/// <summary>
+	/// Sample the beams, which should be done each SAMPLE_PERIOD_MICROS. Both
+	/// laser arrays must share the SPI settings, the columns are read within
+	/// the transaction of the rows.
+	/// </summary>
 	static void run() {
-		uint8_t rowReading[MAX_ROWS];
-		uint8_t columnReading[MAX_COLUMNS];
-		laserPhotoresistorArrayRow.read(rowReading, MAX_ROWS);
-		laserPhotoresistorArrayColumn.read(columnReading, MAX_COLUMNS);
-		for (uint8_t i = 0; i < MAX_ROWS; i++) {
-			photoresistorRow[i]
-				.getLogicOutputWithHysteresis(
-					MAX_ROWS - i -1, rowReading[i] // With reverse index order.
-				);
+		const unsigned long tStartMicros = micros();
+		if (hasSampled) {
+			addBeyondSamplePeriod(TIMING_SAMPLE_PERIOD,
+				tStartMicros - tSampleMicros);
+			tSampleBreakMicros = tSampleMicros;
+		} else {
+			tSampleBreakMicros = tStartMicros;
 		}
-		for (uint8_t i = 0; i < MAX_COLUMNS; i++) {
-			photoresistorColumn[i]
-				.getLogicOutputWithHysteresis(
-					i, columnReading[i]
-				);
+		tSampleMicros = tStartMicros;
+		hasSampled = true;
+		// Both sweeps are interleaved channel by channel within one transaction,
+		// so the rows and columns of a sample are read at about the same time.
+		// Changes are only reported after the whole sweep though, so a beam
+		// that breaks right after a sample is reported up to a sample period
+		// plus this run and the wire time of the message later, which is what
+		// TIMING_LATENCY bounds.
+		laserPhotoresistorArrayRow.beginTransaction();
+		for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+			if (i < MAX_ROWS) {
+				photoresistorRow[i]
+					.getLogicOutputWithHysteresis(
+						MAX_ROWS - i -1, // With reverse index order.
+						laserPhotoresistorArrayRow.readChannel(i)
+					);
+			}
+			if (i < MAX_COLUMNS) {
+				photoresistorColumn[i]
+					.getLogicOutputWithHysteresis(
+						i, laserPhotoresistorArrayColumn.readChannel(i)
+					);
+			}
+		}
+		laserPhotoresistorArrayRow.endTransaction();
+		if (placement.takeChanged() && isPlacementReported) {
+			sendPlacementMessage();
+		}
+		timingStats[TIMING_RUN].add(micros() - tStartMicros);
+	}
+
+	/// <summary>
+	/// Record the latency of the changes reported since the last call. Call
+	/// it right after the output has been handed to the stream, with the
+	/// bytes that wait to be sent up to the end of it, e.g. as counted by
+	/// NonBlockingStream::getQueuedBytes(). They are accounted for with the
+	/// given baud rate.
+	/// </summary>
+	static void recordLatency(unsigned long baud, uint16_t queuedBytes) {
+		if (!hasPendingBreak) {
+			return;
+		}
+		hasPendingBreak = false;
+		const unsigned long tWireMicros = micros() + queuedBytes *
+			(SERIAL_BITS_PER_BYTE * 1000000UL / baud);
+		addBeyondSamplePeriod(TIMING_LATENCY,
+			tWireMicros - tPendingBreakMicros);
+	}
+
+	void handleCapability(byte pin) { }
+
+	boolean handlePinMode(byte pin, int mode) {
+		return false;
+	}
+
+	boolean handlesSysexCommand(byte command) {
+		return (command == TIMING_MESSAGE) ||
+			(command == PLACEMENT_MESSAGE) ||
+			(command == BEAM_STATE_MESSAGE);
+	}
+
+	boolean handleSysex(byte command, byte argc, byte *argv) {
+		return handleSysexSpan(command, SysexSpan(argv, argc));
+	}
+
+	boolean handleSysexSpan(byte command, SysexSpan args) {
+		if ((command == TIMING_MESSAGE) &&
+				args.has(1) && (args[0] < MAX_TIMINGS)) {
+			sendTimingReply(args[0], args.has(2) && (args[1] & TIMING_RESET));
+			return true;
 		}
+		if ((command == PLACEMENT_MESSAGE) && args.has(1)) {
+			isPlacementReported = (args[0] & PLACEMENT_REPORT) != 0;
+			sendPlacementMessage();
+			return true;
+		}
+		if (command == BEAM_STATE_MESSAGE) {
+			sendBeamStateMessage();
+			return true;
+		}
+		return false;
+	}
+
+	void reset() {
+		for (uint8_t i = 0; i < MAX_TIMINGS; i++) {
+			timingStats[i].reset();
+		}
+		isPlacementReported = false;
 	}
 };
 
@@ -149,31 +433,145 @@ public:
 template<
 	typename LaserPhotoresistorArrayRow,
 	typename LaserPhotoresistorArrayColumn,
-	byte MAX_ROWS, byte MAX_COLUMNS
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
 >
 typename ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::OnSignalEdgeListenerRow ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::onSignalEdgeListenerRow;
 
 template<
 	typename LaserPhotoresistorArrayRow,
 	typename LaserPhotoresistorArrayColumn,
-	byte MAX_ROWS, byte MAX_COLUMNS
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
 >
 typename ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::OnSignalEdgeListenerColumn ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::onSignalEdgeListenerColumn;
 
+// Timing monitor
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+TimingStats ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::timingStats[MAX_TIMINGS];
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+unsigned long ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::tSampleMicros = 0;
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+bool ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::hasSampled = false;
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+unsigned long ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::tSampleBreakMicros = 0;
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+unsigned long ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::tPendingBreakMicros = 0;
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+bool ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::hasPendingBreak = false;
+
+// Placement inference
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+PlacementInference<MAX_ROWS, MAX_COLUMNS> ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::placement;
+
+template<
+	typename LaserPhotoresistorArrayRow,
+	typename LaserPhotoresistorArrayColumn,
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
+>
+bool ArrangeGrid<
+	LaserPhotoresistorArrayRow,
+	LaserPhotoresistorArrayColumn,
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
+>::isPlacementReported = false;
+
 #endif // ARRANGE_GRID_H
\ No newline at end of file
@@ -62,15 +62,52 @@ class LaserPhotoresistorArray {
 	static SpiDevice spiDevice;
 
 	enum MCP3008Configuration {
-		// Use all 8 channels @ 8-bits. Do not care for 10 bit resolution.
-		MCP3008_START_BIT            = (1 << 6),
-		MCP3008_SINGLE_NOT_DIFF_CONV = (1 << 5),
-		MCP3008_CHANNEL_MAX          = 8,
-		MCP3008_CHANNEL_LSHIFT       = 2,
-		MCP3008_DUMMY_BYTE           = 0x00
+		// 8-bit framing: two bytes per channel, the second returns B9..B2.
+		MCP3008_START_BIT              = (1 << 6),
+		MCP3008_SINGLE_NOT_DIFF_CONV   = (1 << 5),
+		MCP3008_CHANNEL_MAX            = 8,
+		MCP3008_CHANNEL_LSHIFT         = 2,
+		MCP3008_DUMMY_BYTE             = 0x00,
+		MCP3008_FRAME_BYTES            = 2,
+		// 10-bit framing: three byte aligned, the last two return B9..B0.
+		MCP3008_FRAME10_START_BYTE     = 0x01,
+		MCP3008_FRAME10_SINGLE_CONV    = (1 << 7),
+		MCP3008_FRAME10_CHANNEL_LSHIFT = 4,
+		MCP3008_FRAME10_MSB_MASK       = 0x03,
+		MCP3008_FRAME10_BYTES          = 3
 	};
 
+	static void writeFrame(uint8_t frame[MCP3008_FRAME_BYTES],
+			uint8_t channel) {
+		frame[0] =
+			MCP3008_START_BIT |
+			MCP3008_SINGLE_NOT_DIFF_CONV |
+			(channel << MCP3008_CHANNEL_LSHIFT);
+		frame[1] = MCP3008_DUMMY_BYTE;
+	}
+
+	static void writeFrame10(uint8_t frame[MCP3008_FRAME10_BYTES],
+			uint8_t channel) {
+		frame[0] = MCP3008_FRAME10_START_BYTE;
+		frame[1] =
+			MCP3008_FRAME10_SINGLE_CONV |
+			(channel << MCP3008_FRAME10_CHANNEL_LSHIFT);
+		frame[2] = MCP3008_DUMMY_BYTE;
+	}
+
+	static uint16_t readFrame10(const uint8_t frame[MCP3008_FRAME10_BYTES]) {
+		return ((frame[1] & MCP3008_FRAME10_MSB_MASK) << 8) | frame[2];
+	}
+
 public:
+	/// <summary>
+	/// Estimated duration of reading all photoresistors at 10-bit resolution
+	/// in microseconds.
+	/// </summary>
+	static constexpr uint32_t read10Micros() {
+		return SpiDevice::transferMicros(3, MCP3008_CHANNEL_MAX);
+	}
+
 	/// <summary>
 	/// Initalize sensor and perform software reset.
 	/// </summary>
@@ -81,7 +118,8 @@ public:
 	}
 
 	/// <summary>
-	/// Reads from the photoresistor array.
+	/// Reads from the photoresistor array. All channels are converted in a
+	/// single SPI transaction and only slave select is toggled in between.
 	/// </summary>
 	/// <param name="diodes">
 	/// Array of data bytes to be read. Its content will be overwritten by the
@@ -94,18 +132,107 @@ public:
 	/// The actual number of read photoresistors.
 	/// </returns>
 	static uint8_t read(uint8_t * /*[out]*/ photoresistors, uint8_t length) {
-		const uint8_t MAX_ITEMS = length % (MCP3008_CHANNEL_MAX + 1);
+		const uint8_t MAX_ITEMS = min(length, MCP3008_CHANNEL_MAX);
+#ifdef ARDUINO
+		// On the AVR a frame is converted at a time, so no array of all frames
+		// has to fit on its small stack.
+		spiDevice.beginTransaction();
 		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
-			const uint8_t MCP3008_CONFIG_BYTE =
-				MCP3008_START_BIT |
-				MCP3008_SINGLE_NOT_DIFF_CONV |
-				(i << MCP3008_CHANNEL_LSHIFT);
-			uint8_t buffer[] = { MCP3008_CONFIG_BYTE, MCP3008_DUMMY_BYTE };
-			spiDevice.transferBulk(buffer, sizeof(buffer));
-			photoresistors[i] = buffer[1];
+			uint8_t frame[MCP3008_FRAME_BYTES];
+			writeFrame(frame, i);
+			spiDevice.transferFrame(frame, sizeof(frame));
+			photoresistors[i] = frame[1];
 		}
+		spiDevice.endTransaction();
+#else
+		uint8_t frames[MCP3008_CHANNEL_MAX][MCP3008_FRAME_BYTES];
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			writeFrame(frames[i], i);
+		}
+		spiDevice.beginTransaction();
+		spiDevice.transferFrames(frames[0], MCP3008_FRAME_BYTES, MAX_ITEMS);
+		spiDevice.endTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			photoresistors[i] = frames[i][1];
+		}
+#endif
 		return MAX_ITEMS;
 	}
+
+	/// <summary>
+	/// Reads from the photoresistor array at the full 10-bit resolution. All
+	/// channels are converted in a single SPI transaction.
+	/// </summary>
+	/// <param name="diodes">
+	/// Array of data words to be read. Its content will be overwritten by the
+	/// sensed values.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	/// <returns>
+	/// The actual number of read photoresistors.
+	/// </returns>
+	static uint8_t read(uint16_t * /*[out]*/ photoresistors, uint8_t length) {
+		const uint8_t MAX_ITEMS = min(length, MCP3008_CHANNEL_MAX);
+#ifdef ARDUINO
+		// On the AVR a frame is converted at a time, so no array of all frames
+		// has to fit on its small stack.
+		beginTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			uint8_t frame[MCP3008_FRAME10_BYTES];
+			writeFrame10(frame, i);
+			spiDevice.transferFrame(frame, sizeof(frame));
+			photoresistors[i] = readFrame10(frame);
+		}
+		endTransaction();
+#else
+		uint8_t frames[MCP3008_CHANNEL_MAX][MCP3008_FRAME10_BYTES];
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			writeFrame10(frames[i], i);
+		}
+		beginTransaction();
+		spiDevice.transferFrames(frames[0], MCP3008_FRAME10_BYTES, MAX_ITEMS);
+		endTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			photoresistors[i] = readFrame10(frames[i]);
+		}
+#endif
+		return MAX_ITEMS;
+	}
+
+	/// <summary>
+	/// Begin a transaction to read single channels. Arrays that share the SPI
+	/// settings may read their channels within the transaction of one of
+	/// them, as only their slave select pins differ.
+	/// </summary>
+	static void beginTransaction() {
+		spiDevice.beginTransaction();
+	}
+
+	/// <summary>
+	/// End a transaction begun by beginTransaction().
+	/// </summary>
+	static void endTransaction() {
+		spiDevice.endTransaction();
+	}
+
+	/// <summary>
+	/// Reads one photoresistor at the full 10-bit resolution within a
+	/// transaction.
+	/// </summary>
+	/// <param name="channel">
+	/// The channel of the photoresistor, it must be less than 8.
+	/// </param>
+	/// <returns>
+	/// The sensed value.
+	/// </returns>
+	static uint16_t readChannel(uint8_t channel) {
+		uint8_t frame[MCP3008_FRAME10_BYTES];
+		writeFrame10(frame, channel);
+		spiDevice.transferFrame(frame, sizeof(frame));
+		return readFrame10(frame);
+	}
 };
 
 #endif // LASER_PHOTORESISTOR_ARRAY_H
\ No newline at end of file
@@ -62,31 +62,43 @@ public:
 	};
 
 private:
-	uint8_t negativeTreshold;
-	uint8_t positiveTreshold;
-	uint8_t treshold;
-	const float hysteresis;
+	uint16_t negativeTreshold;
+	uint16_t positiveTreshold;
+	const uint8_t hysteresisPercentage;
 	bool logicLevel;
 	OnSignalEdgeListener * onSignalEdgeListener;
 
 public:
+	enum : uint16_t {
+		// Readings are 10-bit wide as provided by the MCP3008.
+		READING_MAX           = 0x3FF,
+		HYSTERESIS_PERCENTAGE = 10,
+	};
 
-	Photoresistor() : Photoresistor(0, UINT8_MAX) { }
+	Photoresistor() : Photoresistor(0, READING_MAX) { }
 
-	Photoresistor(uint8_t min, uint8_t max) : Photoresistor(min, max, 0.1f) { }
+	Photoresistor(uint16_t min, uint16_t max) :
+		Photoresistor(min, max, HYSTERESIS_PERCENTAGE) { }
 
-	Photoresistor(uint8_t min, uint8_t max,	float hysteresisPercentage) :
-			hysteresis(hysteresisPercentage) {
+	Photoresistor(uint16_t min, uint16_t max, uint8_t hysteresisPercentage) :
+		hysteresisPercentage(hysteresisPercentage) {
 		setTreshold(min, max);
 		logicLevel = LOW;
 		onSignalEdgeListener = nullptr;
 	}
 
-	void setTreshold(uint8_t min, uint8_t max) {
-		const uint8_t difference = max - min;
-		treshold = (difference / 2) + min;
-		negativeTreshold = treshold - (difference * hysteresis);
-		positiveTreshold = treshold + (difference * hysteresis);
+	/// <summary>
+	/// Precompute the comparator tresholds from the calibrated readings. The
+	/// hysteresis band is rounded to the nearest reading in fixed-point.
+	/// </summary>
+	void setTreshold(uint16_t min, uint16_t max) {
+		const uint16_t difference = max - min;
+		const uint16_t treshold = (difference / 2) + min;
+		const uint16_t band = (
+			static_cast<uint32_t>(difference) * hysteresisPercentage + 50
+		) / 100;
+		negativeTreshold = treshold - band;
+		positiveTreshold = treshold + band;
 	}
 
 	void setOnSignalEdgeListener(OnSignalEdgeListener * onSignalEdgeListener) {
@@ -100,7 +112,7 @@ public:
 	/// hysteresis to compensate signal noise. It also invokes the
 	/// OnSignalEdgeListener.
 	/// </summary>
-	bool getLogicOutputWithHysteresis(uint8_t position, uint8_t newReading) {
+	bool getLogicOutputWithHysteresis(uint8_t position, uint16_t newReading) {
 		if ((logicLevel == LOW) && (newReading > positiveTreshold)) {
 			logicLevel = HIGH;
 			if (onSignalEdgeListener != nullptr) {
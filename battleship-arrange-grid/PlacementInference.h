@@ -0,0 +1,198 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PLACEMENT_INFERENCE_H
+#define PLACEMENT_INFERENCE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/// <summary>
+/// Ship placement inference from the blocked row and column beams. The beams
+/// only tell the projections of the ships onto both axes, so it is assumed
+/// that ships are straight, at least two tiles long and do not touch each
+/// other. Each run of adjacent blocked rows paired with a run of adjacent
+/// blocked columns is then a candidate ship rectangle if one of its sides is
+/// a single tile. A candidate is certain if it is the only one along its ship
+/// axis, otherwise its tiles are ambiguous, e.g. for two parallel ships.
+/// </summary>
+template<uint8_t MAX_ROWS, uint8_t MAX_COLUMNS>
+class PlacementInference {
+
+	static_assert(MAX_ROWS <= 8 && MAX_COLUMNS <= 8,
+		"Beams are kept as 8-bit masks.");
+
+	enum {
+		// Runs of a mask, where runs are separated by at least one bit.
+		MAX_RUNS = 4,
+		MIN_SHIP_LENGTH = 2,
+	};
+
+	struct Run {
+		uint8_t first;
+		uint8_t length;
+		uint8_t mask;
+	};
+
+	uint8_t rowMask;
+	uint8_t columnMask;
+	bool changed;
+
+	static uint8_t getRuns(uint8_t mask, Run /*[out]*/ runs[MAX_RUNS]) {
+		uint8_t count = 0;
+		for (uint8_t i = 0; (i < 8) && (count < MAX_RUNS); i++) {
+			if ((mask & (1 << i)) == 0) {
+				continue;
+			}
+			Run & run = runs[count++];
+			run.first = i;
+			run.length = 0;
+			run.mask = 0;
+			while ((i < 8) && (mask & (1 << i))) {
+				run.mask |= (1 << i);
+				run.length++;
+				i++;
+			}
+		}
+		return count;
+	}
+
+	static bool isCandidate(const Run & rowRun, const Run & columnRun) {
+		return ((rowRun.length == 1) || (columnRun.length == 1)) &&
+			(rowRun.length + columnRun.length > MIN_SHIP_LENGTH);
+	}
+
+	static void set(uint8_t & mask, uint8_t position, bool isBlocked) {
+		if (isBlocked) {
+			mask |= (1 << position);
+		} else {
+			mask &= ~(1 << position);
+		}
+	}
+
+public:
+	PlacementInference() : rowMask(0), columnMask(0), changed(false) { }
+
+	void setRowBlocked(uint8_t row, bool isBlocked) {
+		const uint8_t oldMask = rowMask;
+		set(rowMask, row % MAX_ROWS, isBlocked);
+		changed |= (rowMask != oldMask);
+	}
+
+	void setColumnBlocked(uint8_t column, bool isBlocked) {
+		const uint8_t oldMask = columnMask;
+		set(columnMask, column % MAX_COLUMNS, isBlocked);
+		changed |= (columnMask != oldMask);
+	}
+
+	uint8_t getRowMask() const { return rowMask; }
+	uint8_t getColumnMask() const { return columnMask; }
+
+	/// <summary>
+	/// Tell whether the beams changed since the last call.
+	/// </summary>
+	bool takeChanged() {
+		const bool wasChanged = changed;
+		changed = false;
+		return wasChanged;
+	}
+
+	/// <summary>
+	/// Infer the tiles covered by ships.
+	/// </summary>
+	/// <param name="occupied">
+	/// A bitmask of columns per row, set for the tiles of all candidates.
+	/// </param>
+	/// <param name="ambiguous">
+	/// A bitmask of columns per row, set for the occupied tiles that belong
+	/// to candidates which are not certain.
+	/// </param>
+	void infer(uint8_t /*[out]*/ occupied[MAX_ROWS],
+			uint8_t /*[out]*/ ambiguous[MAX_ROWS]) const {
+		Run rowRuns[MAX_RUNS];
+		Run columnRuns[MAX_RUNS];
+		const uint8_t rowRunCount = getRuns(rowMask, rowRuns);
+		const uint8_t columnRunCount = getRuns(columnMask, columnRuns);
+		uint8_t rowCandidates[MAX_RUNS] = { 0 };
+		uint8_t columnCandidates[MAX_RUNS] = { 0 };
+		for (uint8_t r = 0; r < rowRunCount; r++) {
+			for (uint8_t c = 0; c < columnRunCount; c++) {
+				if (isCandidate(rowRuns[r], columnRuns[c])) {
+					rowCandidates[r]++;
+					columnCandidates[c]++;
+				}
+			}
+		}
+		for (uint8_t row = 0; row < MAX_ROWS; row++) {
+			occupied[row] = 0;
+			ambiguous[row] = 0;
+		}
+		for (uint8_t r = 0; r < rowRunCount; r++) {
+			for (uint8_t c = 0; c < columnRunCount; c++) {
+				const Run & rowRun = rowRuns[r];
+				const Run & columnRun = columnRuns[c];
+				if (!isCandidate(rowRun, columnRun)) {
+					continue;
+				}
+				// A horizontal ship is the only one to cover its columns,
+				// a vertical one the only one to cover its rows.
+				const bool isCertain = (rowRun.length == 1) ?
+					(columnCandidates[c] == 1) : (rowCandidates[r] == 1);
+				for (uint8_t row = rowRun.first;
+						row < rowRun.first + rowRun.length; row++) {
+					occupied[row] |= columnRun.mask;
+					if (!isCertain) {
+						ambiguous[row] |= columnRun.mask;
+					}
+				}
+			}
+		}
+	}
+};
+
+#endif // PLACEMENT_INFERENCE_H
@@ -55,7 +55,34 @@
 #include <SpiDevice.h>
 
 /// <summary>
-/// SPI driver with faster slave select pin access for Arduino Uno.
+/// Shift of F_CPU for the fastest SPI clock of the AVR that does not exceed
+/// the given one, from F_CPU / 2 down to F_CPU / 128.
+/// </summary>
+constexpr uint8_t SpiDevicePortB_clockShift(uint32_t fSck, uint8_t shift = 1) {
+	return ((shift < 7) && ((F_CPU >> shift) > fSck))
+		? SpiDevicePortB_clockShift(fSck, shift + 1) : shift;
+}
+
+/// <summary>
+/// State of the SPI bus shared by all devices on it.
+/// </summary>
+struct SpiDevicePortBBus {
+
+	static bool & isUsedInInterrupt() {
+		static bool isUsedInInterrupt = false;
+		return isUsedInInterrupt;
+	}
+
+	static uint8_t & interruptSave() {
+		static uint8_t interruptSave = 0;
+		return interruptSave;
+	}
+};
+
+/// <summary>
+/// SPI driver with faster slave select pin access for Arduino Uno. The SPI
+/// registers are written directly with values computed at compile time,
+/// instead of by the SPI library for each transaction.
 /// </summary>
 template<
 	uint8_t PORTB_PIN,
@@ -65,6 +92,42 @@ template<
 >
 struct SpiDevicePortB {
 
+	enum SpiRegisters {
+		SPI_CLOCK_SHIFT = SpiDevicePortB_clockShift(F_SCK),
+		// F_CPU / 4, 16, 64 and 128, halved by SPI2X except the last.
+		SPCR_VALUE = (1 << SPE) | (1 << MSTR)
+			| ((BIT_ORDER == SpiBitOrderLsbFirst) ? (1 << DORD) : 0)
+			| (MODE & ((1 << CPOL) | (1 << CPHA)))
+			| ((SPI_CLOCK_SHIFT == 7) ? 3 : ((SPI_CLOCK_SHIFT - 1) >> 1)),
+		SPSR_VALUE = ((SPI_CLOCK_SHIFT < 7) && (SPI_CLOCK_SHIFT & 1))
+			? (1 << SPI2X) : 0,
+	};
+
+	enum TimingModel {
+		// Cycles spent per byte besides shifting, i.e. leaving the polling of
+		// SPIF, reading and writing SPDR. The rest overlaps the shifting.
+		BYTE_OVERHEAD_CYCLES        = 4,
+		// Cycles spent per frame to toggle the slave select pin.
+		FRAME_OVERHEAD_CYCLES       = 8,
+		// Time spent to begin and end a transaction including slave select.
+		TRANSACTION_OVERHEAD_MICROS = 2,
+	};
+
+	/// <summary>
+	/// Estimated duration of a transaction of frames in microseconds, i.e. of
+	/// transferBulk() for a single frame. It is used to verify timing budgets
+	/// at compile time. The frame and transaction overheads are those that
+	/// matched the measured 85us for reading all channels of a MCP3008 @ SCK
+	/// 2MHz with the SPI library and one transaction per channel.
+	/// </summary>
+	static constexpr uint32_t transferMicros(uint8_t length,
+		uint8_t frames = 1) {
+		return (frames * (length * (8UL * (F_CPU / F_SCK)
+			+ BYTE_OVERHEAD_CYCLES) + FRAME_OVERHEAD_CYCLES)
+			+ (F_CPU / 1000000UL) - 1) / (F_CPU / 1000000UL)
+			+ TRANSACTION_OVERHEAD_MICROS;
+	}
+
 	/// <summary>
 	/// Initalize the SPI port as bus master.
 	/// </summary>
@@ -75,7 +138,45 @@ struct SpiDevicePortB {
 	}
 
 	/// <summary>
-	/// Transfer bytes on the SPI bus.
+	/// Declare that the SPI bus is used from within an interrupt service
+	/// routine. Transactions outside of it are then performed with interrupts
+	/// masked, such that the interrupt cannot corrupt them.
+	/// </summary>
+	static void usingInterrupt(void) {
+		SpiDevicePortBBus::isUsedInInterrupt() = true;
+	}
+
+	/// <summary>
+	/// Begin a transaction with the settings of this device. Any number of
+	/// frames can be transfered until it is ended again.
+	/// </summary>
+	static void beginTransaction(void) {
+		if (SpiDevicePortBBus::isUsedInInterrupt()) {
+			SpiDevicePortBBus::interruptSave() = SREG;
+			cli();
+		}
+		SPCR = SPCR_VALUE;
+		SPSR = SPSR_VALUE;
+	}
+
+	/// <summary>
+	/// End a transaction begun by beginTransaction().
+	/// </summary>
+	static void endTransaction(void) {
+		if (SpiDevicePortBBus::isUsedInInterrupt()) {
+			SREG = SpiDevicePortBBus::interruptSave();
+		}
+	}
+
+	/// <summary>
+	/// Transfer one frame, i.e. bytes framed by slave select, within a
+	/// transaction. Consecutive frames keep slave select deasserted for at
+	/// least the loop overhead, i.e. about 500ns, which is above 270ns as
+	/// required by the MCP3008 between conversions.
+	/// The next byte is loaded while the current one is shifted, and the
+	/// received one is stored while the next one is shifted, so only SPDR
+	/// access is between the bytes. Unrolling gains nothing, as the loop
+	/// is shorter than a byte at the fastest SCK of F_CPU / 2.
 	/// </summary>
 	/// <param name="data">
 	/// Array of data bytes to be transfered. The content will be sent in order
@@ -84,15 +185,59 @@ struct SpiDevicePortB {
 	/// <param name="length">
 	/// The length of the array.
 	/// </param>
-	static void transferBulk(uint8_t * /*[in,out]*/ data, uint8_t length) {
-		SPI.beginTransaction(SPISettings(F_SCK, BIT_ORDER, MODE));
+	static void transferFrame(uint8_t* /*[in,out]*/ data, uint8_t length) {
 		PORTB &= ~(1 << PORTB_PIN);
-		for (uint8_t i = 0; i < length; i++) {
-			data[i] = SPI.transfer(data[i]);
+		if (length > 0) {
+			SPDR = data[0];
+			for (uint8_t i = 1; i < length; i++) {
+				const uint8_t out = data[i];
+				while (!(SPSR & (1 << SPIF))) { }
+				const uint8_t in = SPDR;
+				SPDR = out;
+				data[i - 1] = in;
+			}
+			while (!(SPSR & (1 << SPIF))) { }
+			data[length - 1] = SPDR;
 		}
 		PORTB |= (1 << PORTB_PIN);
-		SPI.endTransaction();
+	}
+
+	/// <summary>
+	/// Transfer consecutive frames of the same length within a transaction,
+	/// e.g. a conversion of each channel of an ADC.
+	/// </summary>
+	/// <param name="data">
+	/// Array of the frames one after the other. Its content will be
+	/// overwritten by the received bytes.
+	/// </param>
+	/// <param name="length">
+	/// The length of each frame.
+	/// </param>
+	/// <param name="frames">
+	/// The number of frames.
+	/// </param>
+	static void transferFrames(uint8_t* /*[in,out]*/ data,
+			uint8_t length, uint8_t frames) {
+		for (uint8_t i = 0; i < frames; i++) {
+			transferFrame(data + i * length, length);
+		}
+	}
+
+	/// <summary>
+	/// Transfer bytes on the SPI bus.
+	/// </summary>
+	/// <param name="data">
+	/// Array of data bytes to be transfered. The content will be sent in order
+	/// of the array. Its content will be overwritten by the received bytes.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	static void transferBulk(uint8_t* /*[in,out]*/ data, uint8_t length) {
+		beginTransaction();
+		transferFrame(data, length);
+		endTransaction();
 	}
 };
 
-#endif // SPI_DEVICE_PORT_B_H
\ No newline at end of file
+#endif // SPI_DEVICE_PORT_B_H
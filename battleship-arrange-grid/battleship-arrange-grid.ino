@@ -48,63 +48,74 @@
 
 // Configurable Firmata, see also http://firmatabuilder.com
 #include <ConfigurableFirmata.h>
+#include <FirmataExt.h>
+#include <NonBlockingStream.h>
+#include <StreamStatsFirmata.h>
 
 #include "ArrangeGrid.h"
 #include "LaserPhotoresistorArray.h"
 #include "SpiDevicePortB.h"
 
 enum {
-	LASER_ROWS           = 8,
-	LASER_COLUMNS        = 8,
-	PIN_SS_LASER_ROWS    = PB1,     // Digital pin 9 (PORTB.PB1).
-	PIN_SS_LASER_COLUMNS = PB2,     // Digital pin 10 (PORTB.PB2).
-	F_SCK_LASER_ARRAY    = 2000000, // Frequency in Hz.
-	PIN_SIG_LED          = 8,       // Digital pin 8.
-	SIG_LED              = HIGH,
-	SIG_LED_DURATION     = 1000,    // Time between toggle in ms.
-	SAMPLE_REFRESH_RATE  = 10,      // Laser beam sample rate in Hz.
+	LASER_ROWS            = 8,
+	LASER_COLUMNS         = 8,
+	PIN_SS_LASER_ROWS     = PB1,     // Digital pin 9 (PORTB.PB1).
+	PIN_SS_LASER_COLUMNS  = PB2,     // Digital pin 10 (PORTB.PB2).
+	F_SCK_LASER_ARRAY     = 2000000, // Frequency in Hz.
+	PIN_SIG_LED           = 8,       // Digital pin 8.
+	SIG_LED               = HIGH,
+	SIG_LED_DURATION      = 1000,    // Time between toggle in ms.
+	SAMPLE_REFRESH_RATE   = 500,     // Laser beam sample rate in Hz.
+	FIRMATA_OUTPUT_BYTES  = 40,      // Staged Firmata output per loop.
+	FIRMATA_BACKLOG_BYTES = 40,      // Replies waiting for the serial port.
+	FIRMATA_BAUD          = 57600,
+	STREAM_STATS_MESSAGE  = 0x07,    // Sysex query of dropped output.
 };
 
-// Change photoresistor min/max values if calibration is needed.
+// Change photoresistor min/max 10-bit readings if calibration is needed.
 template<
 	typename LaserPhotoresistorArrayRow,
 	typename LaserPhotoresistorArrayColumn,
-	byte MAX_ROWS, byte MAX_COLUMNS
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
 >
 Photoresistor ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::photoresistorRow[] = {
-	{ 0x06, 0x41 },
-	{ 0x0D, 0x41 },
-	{ 0x06, 0x39 },
-	{ 0x07, 0x39 },
-	{ 0x08, 0x3E },
-	{ 0x06, 0x3A },
-	{ 0x04, 0x31 },
-	{ 0x06, 0x34 },
+	{ 0x018, 0x104 },
+	{ 0x034, 0x104 },
+	{ 0x018, 0x0E4 },
+	{ 0x01C, 0x0E4 },
+	{ 0x020, 0x0F8 },
+	{ 0x018, 0x0E8 },
+	{ 0x010, 0x0C4 },
+	{ 0x018, 0x0D0 },
 };
 
-// TODO: Change photoresistor min/max values if calibration is needed.
+// TODO: Change photoresistor min/max 10-bit readings if calibration is needed.
 template<
 	typename LaserPhotoresistorArrayRow,
 	typename LaserPhotoresistorArrayColumn,
-	byte MAX_ROWS, byte MAX_COLUMNS
+	byte MAX_ROWS, byte MAX_COLUMNS,
+	uint16_t SAMPLE_RATE
 >
 Photoresistor ArrangeGrid<
 	LaserPhotoresistorArrayRow,
 	LaserPhotoresistorArrayColumn,
-	MAX_ROWS, MAX_COLUMNS
+	MAX_ROWS, MAX_COLUMNS,
+	SAMPLE_RATE
 >::photoresistorColumn[] = {
-	{ 0x04, 0x28 },
-	{ 0x04, 0x24 },
-	{ 0x06, 0x27 },
-	{ 0x07, 0x26 },
-	{ 0x07, 0x2F },
-	{ 0x04, 0x24 },
-	{ 0x08, 0x2C },
-	{ 0x04, 0x28 },
+	{ 0x010, 0x0A0 },
+	{ 0x010, 0x090 },
+	{ 0x018, 0x09C },
+	{ 0x01C, 0x098 },
+	{ 0x01C, 0x0BC },
+	{ 0x010, 0x090 },
+	{ 0x020, 0x0B0 },
+	{ 0x010, 0x0A0 },
 };
 
 ArrangeGrid<
@@ -114,13 +125,31 @@ ArrangeGrid<
 	LaserPhotoresistorArray<
 		SpiDevicePortB<PIN_SS_LASER_COLUMNS, F_SCK_LASER_ARRAY>
 	>,
-	LASER_ROWS, LASER_COLUMNS
+	LASER_ROWS, LASER_COLUMNS,
+	SAMPLE_REFRESH_RATE
 > arrangeGrid;
 
+FirmataExt firmataExt;
+byte firmataOutput[FIRMATA_OUTPUT_BYTES];
+byte firmataBacklog[FIRMATA_BACKLOG_BYTES];
+NonBlockingStream firmataStream(
+	Serial, firmataBacklog, sizeof(firmataBacklog));
+StreamStatsFirmata streamStats(firmataStream, STREAM_STATS_MESSAGE);
+
 void setup() {
 	Firmata.setFirmwareVersion(FIRMWARE_MAJOR_VERSION, FIRMWARE_MINOR_VERSION);
 	Firmata.disableBlinkVersion();
-	Firmata.begin();
+	firmataExt.addFeature(arrangeGrid);
+	firmataExt.addFeature(streamStats);
+	firmataStream.setLowPriority(arrangeGrid.ROW_CHANGE_MESSAGE);
+	firmataStream.setLowPriority(arrangeGrid.COLUMN_CHANGE_MESSAGE);
+	firmataStream.setLowPriority(arrangeGrid.ROW_RESTORE_MESSAGE);
+	firmataStream.setLowPriority(arrangeGrid.COLUMN_RESTORE_MESSAGE);
+	Firmata.attach(SYSTEM_RESET, systemResetCallback);
+	Serial.begin(FIRMATA_BAUD);
+	Firmata.begin(firmataStream);
+	Firmata.setOutputBuffer(firmataOutput, sizeof(firmataOutput));
+	systemResetCallback();
 	arrangeGrid.begin();
 	pinMode(PIN_SIG_LED, OUTPUT);
 }
@@ -128,6 +157,11 @@ void setup() {
 void loop() {
 	runFirmata();
 	runGrid();
+	// Hand the replies and beam changes of this loop over at once. If the
+	// serial port is busy, beam changes are dropped rather than waited for,
+	// the host can resynchronise with the BEAM_STATE_MESSAGE.
+	Firmata.flush();
+	arrangeGrid.recordLatency(FIRMATA_BAUD, firmataStream.getQueuedBytes());
 }
 
 void runFirmata() {
@@ -136,13 +170,22 @@ void runFirmata() {
 	}
 }
 
+void systemResetCallback() {
+	// Drop the opt-ins and statistics of the previous host session.
+	firmataExt.reset();
+}
+
 void runGrid() {
-	static unsigned long tStart = millis();
-	unsigned long tStop = millis();
-	if ((tStop - tStart) >= (1000 / SAMPLE_REFRESH_RATE)) {
+	static unsigned long tStart = micros();
+	const unsigned long tStop = micros();
+	if ((tStop - tStart) >= arrangeGrid.SAMPLE_PERIOD_MICROS) {
 		digitalWrite(PIN_SIG_LED, SIG_LED);
 		arrangeGrid.run();
-		tStart = tStop;
+		// Keep the rate without drift, but skip samples that have been missed.
+		tStart += arrangeGrid.SAMPLE_PERIOD_MICROS;
+		if ((tStop - tStart) >= arrangeGrid.SAMPLE_PERIOD_MICROS) {
+			tStart = tStop;
+		}
 		digitalWrite(PIN_SIG_LED, !SIG_LED);
 	}
 }
@@ -45,36 +45,105 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
-
 #ifndef ATTACK_GRID_H
 #define ATTACK_GRID_H
 
 #include <Arduino.h>
+#include <TimerOne.h>
 #include <stdint.h>
 
 #include "GameGrid.h"
-#include "Photodiode.h"
+#include "PhotodiodeBank.h"
+#include <TimingStats.h>
+
+// Define ATTACK_GRID_PROFILE to measure each phase of the scan, the statistics
+// are queried with the PROFILE_MESSAGE. It is compiled out by default as it
+// takes about 130 bytes of RAM and a few us per column.
+
+/// <summary>
+/// Whether two devices are on the same bus, i.e. they cannot transfer at the
+/// same time. Each SPI driver names the bus it uses as its Bus type.
+/// </summary>
+template<typename Bus, typename OtherBus>
+struct AttackGridSameBus {
+	enum { value = false };
+};
+
+template<typename Bus>
+struct AttackGridSameBus<Bus, Bus> {
+	enum { value = true };
+};
 
 /// <summary>
 /// Attacker grid driver. Each item can be sensed by using the red RGB LED as a
 /// light sensor and be colored after a given event has been detected.
+/// The colors are shown with binary code modulation (BCM) such that each color
+/// channel of a tile has a depth of BITS_PER_COLOR bits.
 /// </summary>
 template<
 	typename RgbLedMatrix,
 	typename RgbLedPhotodiodeArray,
 	uint8_t MAX_ROWS = 8, uint8_t MAX_COLUMNS = 8,
-	uint8_t FPS = 100
+	uint8_t FPS = 100,
+	uint8_t BITS_PER_COLOR = 4
 >
 class AttackGrid : public GameGrid::Tile {
 
+public:
+	/// <summary>
+	/// Selects what drives the display and sense algorithm.
+	/// </summary>
+	enum class ScanMode {
+		POLLING,        // Polled by run() from the main loop.
+		TIMER_INTERRUPT // Invoked by the Timer1 overflow interrupt.
+	};
+
+	/// <summary>
+	/// Appearance of a tile type. The color is encoded as 0xRRGGBB, which are
+	/// the same values as the color codes of FastLED, e.g. CRGB::Cyan.
+	/// </summary>
+	struct TileStyle {
+		uint32_t color;
+		bool blinking;
+	};
+
+	enum {
+		TILE_TYPES = static_cast<uint8_t>(Tile::Type::SELECTED) + 1,
+	};
+
+	/// <summary>
+	/// Phases of the scan measured with ATTACK_GRID_PROFILE.
+	/// </summary>
+	enum Phase {
+		PHASE_WRITE_COLUMN,  // SPI transfer of a column to the LED matrix.
+		PHASE_CHARGE_WAIT,   // Red LEDs charging up before they are sensed.
+		PHASE_ADC_SWEEP,     // MCP3008 readings of the photodiodes.
+		PHASE_COMPARATOR,    // Evaluation of the readings of a column.
+		PHASE_FIRMATA_PARSE, // Messages of the remote computer, see sketch.
+		MAX_PHASES
+	};
+
+	/// <summary>
+	/// Query the statistics of a phase:
+	/// 0xF0 0x06 phase [flags] 0xF7
+	/// The reply holds count, min, max and average in us followed by the
+	/// histogram, each as 16-bit value LSB first and 7-bit encoded:
+	/// 0xF0 0x06 phase stats... 0xF7
+	/// </summary>
+	static const byte PROFILE_MESSAGE = 0x06;
+	enum ProfileFlags {
+		PROFILE_RESET = 0x01, // Reset the phase once it has been reported.
+	};
+
+private:
 	struct OnSignalEdgeListenerMatrix :
-		public Photodiode::OnSignalEdgeListener {
+		public PhotodiodeBank<MAX_ROWS>::OnSignalEdgeListener {
 		virtual ~OnSignalEdgeListenerMatrix() { }
-		virtual void onRaisingSignalEdge(uint8_t row, uint8_t column) { }
-		virtual void onFallingSignalEdge(uint8_t row, uint8_t column) {
-			if (tiles[row][column] == Tile::Type::NONE) {
-				sendTileChangeMessage(row, column);
-			}
+		virtual void onRaisingSignalEdges(uint8_t column, uint8_t rows) { }
+		virtual void onFallingSignalEdges(uint8_t column, uint8_t rows) {
+			// May be invoked from within the timer interrupt. Only remember
+			// the edges, they get reported from run() outside of it.
+			pendingTileChanges[column] |= rows;
 		}
 	};
 
@@ -84,61 +153,274 @@ class AttackGrid : public GameGrid::Tile {
 		COLUMN_MAX = MAX_COLUMNS,
 	};
 
+	enum BcmConstants {
+		// Duration of the least significant bit. Each column is shown for
+		// tDiffMicros, which is split into 2^BITS_PER_COLOR - 1 time bases.
+		BCM_TIME_BASE = tDiffMicros / ((1 << BITS_PER_COLOR) - 1),
+		BCM_BIT_START = 0,
+		BCM_BIT_MAX = BITS_PER_COLOR,
+		// Bit of an 8-bit color channel that is shown in the first interval.
+		BCM_LSB_SHIFT = 8 - BITS_PER_COLOR,
+		// Blinking tiles toggle twice per second.
+		BLINK_FRAMES = FPS / 2,
+		// Execution time of the interrupt besides the SPI transfers.
+		ISR_OVERHEAD_MICROS = 10,
+	};
+
+	// Timing model: each bit interval must fit the column write, and the
+	// interval of the most significant bit must also fit the sensing.
+	static_assert(BITS_PER_COLOR >= 2 && BITS_PER_COLOR <= 8,
+		"BITS_PER_COLOR must be within 2 to 8 bits, the red LEDs charge up "
+		"during the intervals before the most significant bit.");
+	static_assert(MAX_ROWS <= GameGrid::MAX_ROWS &&
+		MAX_COLUMNS <= GameGrid::MAX_COLUMNS,
+		"The grid must fit into the tile change frame bitmap.");
+	static_assert(BCM_TIME_BASE >=
+		RgbLedMatrix::writeColumnMicros() + ISR_OVERHEAD_MICROS,
+		"BCM time base is too short to write a column, lower the FPS, "
+		"BITS_PER_COLOR, or raise F_SCK of the LED matrix.");
+	static_assert((BCM_TIME_BASE << (BITS_PER_COLOR - 1)) >=
+		RgbLedMatrix::writeColumnMicros()
+		+ RgbLedPhotodiodeArray::read10Micros() + ISR_OVERHEAD_MICROS,
+		"BCM MSB interval is too short to sense a column, lower the FPS, "
+		"BITS_PER_COLOR, or raise F_SCK of the photodiode array.");
+
+	enum Color {
+		RED,
+		GREEN,
+		BLUE,
+		MAX_COLORS
+	};
+
+	// With a bus of its own, the LED matrix is shifted each interval ahead,
+	// the next column while the photodiodes are read, see shiftInterval().
+	template<bool IS_PIPELINED>
+	struct Pipelining { };
+	typedef Pipelining<!AttackGridSameBus<
+		typename RgbLedMatrix::Bus,
+		typename RgbLedPhotodiodeArray::Bus
+	>::value> ScanPipelining;
+
 	static RgbLedMatrix rgbLedMatrix;
 	static RgbLedPhotodiodeArray rgbLedPhotodiodeArray;
-	static Photodiode photodiodes[MAX_ROWS][MAX_COLUMNS];
+	static PhotodiodeBank<MAX_ROWS> photodiodeBanks[MAX_COLUMNS];
+	static const TileStyle tileStyles[TILE_TYPES];
 	static Tile::Type tiles[MAX_ROWS][MAX_COLUMNS];
+	struct Frame {
+		// Bit planes of each column. For each bit of the color depth there is
+		// a bitfield of the enabled rows for each color.
+		uint8_t planes[MAX_COLUMNS][BITS_PER_COLOR][MAX_COLORS];
+		// Bitfield of the blinking rows of each column.
+		uint8_t blinks[MAX_COLUMNS];
+	};
+	// The front frame is shown, the back frame is staged by bulk updates or
+	// drawn pixels and swapped in at the next frame boundary.
+	static Frame frameBuffers[2];
+	static volatile uint8_t frontFrame;
+	static volatile bool swapPending;
+	// The back frame is being drawn between beginPixels() and endPixels().
+	static bool isDrawingPixels;
 	static OnSignalEdgeListenerMatrix onSignalEdgeListenerMatrix;
+	static volatile uint8_t pendingTileChanges[MAX_COLUMNS];
+	// Number of completed scans of all columns, it wraps around.
+	static volatile uint8_t frameCount;
+	static ScanMode scanMode;
+#ifdef ATTACK_GRID_PROFILE
+	static TimingStats phaseStats[MAX_PHASES];
+#endif
 
-	static void displayAndSenseAlgorithm() {
-		static uint8_t column = 0;
-		// Determine which color of the current column LEDs should be enabled.
-		uint8_t colReds = 0x00, colGreens = 0x00, colBlues = 0x00;
-		for (uint8_t row = 0; row < MAX_ROWS; row++) {
-			Tile::Type tile = tiles[row][column];
-			const uint8_t enabledColor = (1 << row);
-			switch (tile) {
-			case Tile::Type::DESTROYED:
-				colReds |= enabledColor;
-				break;
-			case Tile::Type::HIT:
-				colReds |= enabledColor;
-				colGreens |= enabledColor;
-				break;
-			case Tile::Type::WATER:
-				colBlues |= enabledColor;
-				break;
-			default:
-				colGreens |= enabledColor;
-				colBlues |= enabledColor;
+	/// <summary>
+	/// Show the next bit interval and sense each column during the interval of
+	/// its most significant bit. There is no busy waiting in here, therefore
+	/// it is short enough to be executed from within the Timer1 interrupt.
+	/// </summary>
+	/// <returns>
+	/// The duration of the interval that has just been started in us.
+	/// </returns>
+	static uint16_t binaryCodeModulationAlgorithm() {
+		static uint8_t column = COLUMN_START;
+		static uint8_t bcmBit = BCM_BIT_START;
+		static uint8_t blinkFrame = 0;
+		static uint16_t tColumnMicros = 0;
+		static bool isColumnShifted = false;
+		const uint16_t tStartMicros = startTiming();
+		if (isColumnShifted) {
+			latchColumn(ScanPipelining());
+			isColumnShifted = false;
+		} else {
+			displayColumn(column, bcmBit, (blinkFrame >= BLINK_FRAMES));
+		}
+		stopTiming(PHASE_WRITE_COLUMN, tStartMicros);
+		if (bcmBit == BCM_BIT_START) {
+			tColumnMicros = tStartMicros;
+		}
+		const uint8_t shownColumn = column;
+		const bool isSensing = (bcmBit == (BCM_BIT_MAX - 1));
+		const uint16_t tDiffMicros = (uint16_t)BCM_TIME_BASE << bcmBit;
+		// Prepare for the next BCM interval.
+		bcmBit++;
+		if (bcmBit >= BCM_BIT_MAX) {
+			bcmBit = BCM_BIT_START;
+			column++;
+			if (column >= COLUMN_MAX) {
+				column = COLUMN_START; // Restart on first column.
+				if (swapPending) {
+					frontFrame ^= 1;
+					swapPending = false;
+				}
+				frameCount++;
+				blinkFrame++;
+				if (blinkFrame >= 2 * BLINK_FRAMES) {
+					blinkFrame = 0;
+				}
 			}
 		}
-		// Write the result to the shift registers of the LED matrix.
-		rgbLedMatrix.writeColumn(colReds, colGreens, colBlues, column);
-		// Wait for the red leds such that they charge up with photons.
-		//delay(3);
-		delayMicroseconds(500);
-		//delayMicroseconds(tDiffMicros / 10);
-		// Takes 85us per scan @ SCK 2MHz.
-		rgbLedSenseAlgortihm(column);
-		// Update column.
-		column++;
-		if (column >= MAX_COLUMNS) {
-			column = 0; // Restart on first column.
-		}
-	}
-
-	static void rgbLedSenseAlgortihm(uint8_t column) {
-		uint8_t redLedPhotodiodesLit[MAX_ROWS] = { 0 };
-		rgbLedPhotodiodeArray.read(redLedPhotodiodesLit, MAX_ROWS);
-		// TODO: Write code to transmit sensed positions back to the computer.
-		for (uint8_t row = 0; row < MAX_ROWS; row++) {
-			photodiodes[row][column]
-				.getLogicOutputWithHysteresis(
-					row, column,
-					redLedPhotodiodesLit[row]
-				);
+		if (isSensing) {
+			// The red leds have been charging up with photons during the
+			// shorter intervals. Takes 85us per scan @ SCK 2MHz, measure it
+			// with ATTACK_GRID_PROFILE.
+			stopTiming(PHASE_CHARGE_WAIT, tColumnMicros);
+			isColumnShifted = rgbLedSenseAlgortihm(shownColumn,
+				column, (blinkFrame >= BLINK_FRAMES));
+		} else {
+			isColumnShifted = shiftInterval(column, bcmBit,
+				(blinkFrame >= BLINK_FRAMES), ScanPipelining());
 		}
+		return tDiffMicros;
+	}
+
+	static void onTimerInterrupt() {
+		Timer1.setPeriod(binaryCodeModulationAlgorithm());
+	}
+
+	static void displayColumn(uint8_t column, uint8_t bcmBit, bool blinkOff,
+			void (*write)(uint8_t, uint8_t, uint8_t, uint8_t)
+				= &RgbLedMatrix::writeColumn) {
+		const Frame & frame = frameBuffers[frontFrame];
+		const uint8_t * colColors = frame.planes[column][bcmBit];
+		const uint8_t enabledRows = blinkOff ? ~frame.blinks[column] : 0xFF;
+		write(
+			colColors[RED] & enabledRows,
+			colColors[GREEN] & enabledRows,
+			colColors[BLUE] & enabledRows,
+			column
+		);
+	}
+
+	/// <summary>
+	/// Sense the column that is shown. The first interval of the next column
+	/// is shifted meanwhile if the LED matrix has a bus of its own.
+	/// </summary>
+	/// <returns>
+	/// True if the next column has been shifted and only needs to be latched.
+	/// </returns>
+	static bool rgbLedSenseAlgortihm(uint8_t column,
+			uint8_t nextColumn, bool nextBlinkOff) {
+		uint16_t redLedPhotodiodesLit[MAX_ROWS] = { 0 };
+		uint16_t tStartMicros = startTiming();
+		const bool isNextColumnShifted = readPhotodiodes(redLedPhotodiodesLit,
+			nextColumn, nextBlinkOff, ScanPipelining());
+		stopTiming(PHASE_ADC_SWEEP, tStartMicros);
+		tStartMicros = startTiming();
+		photodiodeBanks[column]
+			.getLogicOutputsWithHysteresis(column, redLedPhotodiodesLit);
+		stopTiming(PHASE_COMPARATOR, tStartMicros);
+		return isNextColumnShifted;
+	}
+
+	/// <summary>
+	/// The LED matrix shares the bus, so the next column is written once the
+	/// photodiodes have been read.
+	/// </summary>
+	static bool readPhotodiodes(uint16_t * readings,
+			uint8_t nextColumn, bool nextBlinkOff, Pipelining<false>) {
+		rgbLedPhotodiodeArray.read(readings, MAX_ROWS);
+		return false;
+	}
+
+	/// <summary>
+	/// The LED matrix has a bus of its own, so the next column is shifted
+	/// between the conversions while the current one is still shown.
+	/// </summary>
+	static bool readPhotodiodes(uint16_t * readings,
+			uint8_t nextColumn, bool nextBlinkOff, Pipelining<true>) {
+		displayColumn(nextColumn, BCM_BIT_START, nextBlinkOff,
+			&RgbLedMatrix::shiftColumn);
+		rgbLedPhotodiodeArray.read(readings, MAX_ROWS,
+			&RgbLedMatrix::continueColumn);
+		return true;
+	}
+
+	/// <summary>
+	/// The LED matrix shares the bus, so each interval is written when it
+	/// starts.
+	/// </summary>
+	static bool shiftInterval(uint8_t column, uint8_t bcmBit, bool blinkOff,
+			Pipelining<false>) {
+		return false;
+	}
+
+	/// <summary>
+	/// The LED matrix has a bus of its own, so the next interval is shifted
+	/// ahead and only latched when it starts. Then each interval starts
+	/// equally soon after the interrupt, whether it has been shifted while
+	/// sensing or not. Tiles set meanwhile show up an interval later.
+	/// </summary>
+	static bool shiftInterval(uint8_t column, uint8_t bcmBit, bool blinkOff,
+			Pipelining<true>) {
+		displayColumn(column, bcmBit, blinkOff, &RgbLedMatrix::shiftColumn);
+		rgbLedMatrix.flushColumn();
+		return true;
+	}
+
+	static void latchColumn(Pipelining<false>) { }
+
+	static void latchColumn(Pipelining<true>) {
+		rgbLedMatrix.latchColumn();
+	}
+
+	/// <summary>
+	/// Encode a color into the bit planes of a frame. Only the BITS_PER_COLOR
+	/// most significant bits of each channel are shown.
+	/// </summary>
+	static void writeColor(Frame & frame, uint8_t row, uint8_t column,
+			uint8_t red, uint8_t green, uint8_t blue, bool blinking) {
+		const uint8_t channels[MAX_COLORS] = { red, green, blue };
+		const uint8_t enabledColor = (1 << row);
+		for (uint8_t bcmBit = 0; bcmBit < BCM_BIT_MAX; bcmBit++) {
+			uint8_t * colColors = frame.planes[column][bcmBit];
+			const uint8_t bcmBitmask = (1 << (BCM_LSB_SHIFT + bcmBit));
+			for (uint8_t c = 0; c < MAX_COLORS; c++) {
+				if (channels[c] & bcmBitmask) {
+					colColors[c] |= enabledColor;
+				} else {
+					colColors[c] &= ~enabledColor;
+				}
+			}
+		}
+		if (blinking) {
+			frame.blinks[column] |= enabledColor;
+		} else {
+			frame.blinks[column] &= ~enabledColor;
+		}
+	}
+
+	/// <summary>
+	/// Encode the style of a tile type into the bit planes of a frame.
+	/// </summary>
+	static void writeTile(Frame & frame,
+			uint8_t row, uint8_t column, Tile::Type type) {
+		uint8_t style = static_cast<uint8_t>(type);
+		if (style >= TILE_TYPES) {
+			style = static_cast<uint8_t>(Tile::Type::NONE);
+		}
+		const uint32_t color = tileStyles[style].color;
+		writeColor(frame, row, column,
+			(uint8_t)(color >> 16), // Red.
+			(uint8_t)(color >> 8),  // Green.
+			(uint8_t)(color),       // Blue.
+			tileStyles[style].blinking
+		);
 	}
 
 	static void doReset() {
@@ -153,16 +435,113 @@ class AttackGrid : public GameGrid::Tile {
 		}
 	}
 
+	/// <summary>
+	/// Report the tile changes that have been sensed since the last call.
+	/// Either each change is sent on its own, or if the remote computer has
+	/// opted in, all changes sensed during the last frame are sent as one
+	/// bitmap right after the frame has been completed. While the serial port
+	/// has no room for a report, its changes stay pending and are coalesced
+	/// with later ones, only changes of tiles that are no longer untouched
+	/// are discarded.
+	/// </summary>
+	static void reportTileChanges() {
+		static uint8_t reportedFrame = 0;
+		const bool frameMessage = isFeatureEnabled(FEATURE_TILE_CHANGE_FRAME);
+		const uint8_t frame = frameCount;
+		if (frameMessage && (frame == reportedFrame)) {
+			return; // Already reported within this frame.
+		}
+		if (frameMessage &&
+				(Firmata.availableForWrite() < Tile::TILE_CHANGE_FRAME_BYTES)) {
+			return; // Retried with the changes of the next loops added.
+		}
+		uint8_t changedFrame[GameGrid::MAX_COLUMNS] = { 0x00 };
+		bool hasChanged = false;
+		for (uint8_t column = 0; column < MAX_COLUMNS; column++) {
+			const uint8_t changedRows = pendingTileChanges[column];
+			uint8_t reportedRows = 0x00;
+			for (uint8_t row = 0; row < MAX_ROWS; row++) {
+				if (!(changedRows & (1 << row))) {
+					continue;
+				}
+				if (tiles[row][column] != Tile::Type::NONE) {
+					reportedRows |= (1 << row); // Redundant, it is not shown.
+				} else if (frameMessage) {
+					changedFrame[column] |= (1 << row);
+					reportedRows |= (1 << row);
+					hasChanged = true;
+				} else if (Firmata.availableForWrite() >=
+						Tile::TILE_CHANGE_BYTES) {
+					sendTileChangeMessage(row, column);
+					reportedRows |= (1 << row);
+				}
+			}
+			// The interrupt may have added changes meanwhile, keep them.
+			const uint8_t oldSREG = SREG;
+			cli();
+			pendingTileChanges[column] &= ~reportedRows;
+			SREG = oldSREG;
+		}
+		if (hasChanged) {
+			sendTileChangeFrameMessage(changedFrame, frame);
+		}
+		reportedFrame = frame;
+	}
+
+#ifdef ATTACK_GRID_PROFILE
+	/// <summary>
+	/// Report the statistics of a phase. They are copied with the interrupt
+	/// masked, as the interrupt keeps adding to them.
+	/// </summary>
+	static void sendProfileReply(byte phase, bool reset) {
+		const uint8_t oldSREG = SREG;
+		cli();
+		const TimingStats stats = phaseStats[phase];
+		if (reset) {
+			phaseStats[phase].reset();
+		}
+		SREG = oldSREG;
+		const uint16_t summary[] = {
+			stats.getCount(),
+			stats.getMinMicros(),
+			stats.getMaxMicros(),
+			stats.getAverageMicros()
+		};
+		Firmata.write(START_SYSEX);
+		Firmata.write(PROFILE_MESSAGE);
+		Firmata.write(phase);
+		Encoder7Bit.startBinaryWrite();
+		for (uint8_t i = 0; i < sizeof(summary) / sizeof(summary[0]); i++) {
+			Encoder7Bit.writeBinary(summary[i] & 0xFF);
+			Encoder7Bit.writeBinary(summary[i] >> 8);
+		}
+		for (uint8_t i = 0; i < TimingStats::HISTOGRAM_BUCKETS; i++) {
+			Encoder7Bit.writeBinary(stats.getHistogram(i) & 0xFF);
+			Encoder7Bit.writeBinary(stats.getHistogram(i) >> 8);
+		}
+		Encoder7Bit.endBinaryWrite();
+		Firmata.write(END_SYSEX);
+	}
+#endif
+
 public:
-	static void begin() {
+	static void begin(ScanMode mode = ScanMode::TIMER_INTERRUPT) {
+		scanMode = mode;
 		rgbLedMatrix.begin();
 		rgbLedPhotodiodeArray.begin();
 		doReset();
-		for (uint8_t i = 0; i < MAX_ROWS; i++) {
-			for (uint8_t j = 0; j < MAX_COLUMNS; j++) {
-				photodiodes[i][j]
-					.setOnSignalEdgeListener(&onSignalEdgeListenerMatrix);
-			}
+		for (uint8_t column = 0; column < MAX_COLUMNS; column++) {
+			photodiodeBanks[column]
+				.setOnSignalEdgeListener(&onSignalEdgeListenerMatrix);
+		}
+		const uint16_t tDiffFirstMicros = binaryCodeModulationAlgorithm();
+		if (scanMode == ScanMode::TIMER_INTERRUPT) {
+			// The SPI bus is accessed from within the interrupt from now on,
+			// transactions elsewhere must mask it to not get corrupted.
+			rgbLedMatrix.usingInterrupt();
+			rgbLedPhotodiodeArray.usingInterrupt();
+			Timer1.initialize(tDiffFirstMicros);
+			Timer1.attachInterrupt(onTimerInterrupt);
 		}
 	}
 
@@ -171,28 +550,175 @@ public:
 			doReset();
 			shouldReset = false;
 		}
-		static unsigned long tStartMicros = micros();
-		unsigned long tStopMicros = micros();
-		if ((tStopMicros - tStartMicros) >= tDiffMicros) {
-			displayAndSenseAlgorithm();
-			tStartMicros = tStopMicros;
+		if (scanMode == ScanMode::POLLING) {
+			static unsigned long tStartMicros = micros();
+			static uint16_t tDiffBcmMicros = BCM_TIME_BASE;
+			unsigned long tStopMicros = micros();
+			if ((tStopMicros - tStartMicros) >= tDiffBcmMicros) {
+				tDiffBcmMicros = binaryCodeModulationAlgorithm();
+				tStartMicros = tStopMicros;
+			}
 		}
+		reportTileChanges();
 	}
 
 	static void setTile(uint8_t row, uint8_t column, Tile::Type type) {
+		if ((row >= MAX_ROWS) || (column >= MAX_COLUMNS)) {
+			return;
+		}
 		tiles[row][column] = type;
+		// Update the affected column of the shown frame in place. It is read
+		// from the timer interrupt, so do not let it see a partial update.
+		// A staged or drawn frame must be kept up to date as well as it
+		// replaces the shown frame soon.
+		const uint8_t oldSREG = SREG;
+		cli();
+		writeTile(frameBuffers[frontFrame], row, column, type);
+		if (swapPending || isDrawingPixels) {
+			writeTile(frameBuffers[frontFrame ^ 1], row, column, type);
+		}
+		SREG = oldSREG;
+	}
+
+	/// <summary>
+	/// Set a rectangle of tiles at once. The tiles are staged in the back
+	/// frame, which is shown from the next frame boundary on. Thus the
+	/// display never shows a partially updated rectangle.
+	/// </summary>
+	static void setTiles(uint8_t row, uint8_t column,
+			uint8_t rows, uint8_t columns, const uint8_t * packedTypes) {
+		// Hold back a pending swap while the back frame is modified. It
+		// already contains all changes since it has been staged, just like a
+		// frame that is being drawn.
+		uint8_t oldSREG = SREG;
+		cli();
+		const bool wasPending = swapPending;
+		swapPending = false;
+		SREG = oldSREG;
+		const uint8_t backFrame = frontFrame ^ 1;
+		if (!wasPending && !isDrawingPixels) {
+			frameBuffers[backFrame] = frameBuffers[frontFrame];
+		}
+		uint8_t index = 0;
+		for (uint8_t r = row; r < row + rows; r++) {
+			for (uint8_t c = column; c < column + columns; c++) {
+				const Tile::Type type = getPackedTileType(packedTypes, index++);
+				tiles[r][c] = type;
+				writeTile(frameBuffers[backFrame], r, c, type);
+			}
+		}
+		if (!isDrawingPixels) {
+			oldSREG = SREG;
+			cli();
+			swapPending = true;
+			SREG = oldSREG;
+		}
+	}
+
+	/// <summary>
+	/// Begin to draw a whole frame of pixels, e.g. from the FastLED controller
+	/// AttackGridLedController. The back frame is drawn from the tiles, the
+	/// pixels only replace the untouched ones. It replaces the shown frame at
+	/// the next frame boundary after endPixels(), tiles set in between are
+	/// drawn into both.
+	/// </summary>
+	static void beginPixels() {
+		const uint8_t oldSREG = SREG;
+		cli();
+		swapPending = false;
+		isDrawingPixels = true;
+		SREG = oldSREG;
+		Frame & frame = frameBuffers[frontFrame ^ 1];
+		for (uint8_t row = 0; row < MAX_ROWS; row++) {
+			for (uint8_t column = 0; column < MAX_COLUMNS; column++) {
+				writeTile(frame, row, column, tiles[row][column]);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Draw a pixel of the frame begun by beginPixels() if its tile is
+	/// untouched. Untouched tiles are sensed with their red LED, so the red
+	/// channel is kept dark.
+	/// </summary>
+	static void setPixel(uint8_t row, uint8_t column,
+			uint8_t red, uint8_t green, uint8_t blue) {
+		if ((row >= MAX_ROWS) || (column >= MAX_COLUMNS) ||
+				(tiles[row][column] != Tile::Type::NONE)) {
+			return;
+		}
+		writeColor(frameBuffers[frontFrame ^ 1], row, column,
+			0x00, green, blue, false);
+	}
+
+	/// <summary>
+	/// Show the frame drawn since beginPixels() from the next frame boundary
+	/// on.
+	/// </summary>
+	static void endPixels() {
+		const uint8_t oldSREG = SREG;
+		cli();
+		isDrawingPixels = false;
+		swapPending = true;
+		SREG = oldSREG;
+	}
+
+	/// <summary>
+	/// Start to measure a phase, e.g. from the sketch. Without
+	/// ATTACK_GRID_PROFILE it compiles to nothing just like stopTiming().
+	/// </summary>
+	static uint16_t startTiming() {
+#ifdef ATTACK_GRID_PROFILE
+		return micros();
+#else
+		return 0;
+#endif
+	}
+
+	static void stopTiming(Phase phase, uint16_t tStartMicros) {
+#ifdef ATTACK_GRID_PROFILE
+		phaseStats[phase].add((uint16_t)micros() - tStartMicros);
+#endif
+	}
+
+#ifdef ATTACK_GRID_PROFILE
+	boolean handlesSysexCommand(byte command) {
+		return (command == PROFILE_MESSAGE) ||
+			Tile::handlesSysexCommand(command);
+	}
+
+	boolean handleSysexSpan(byte command, SysexSpan args) {
+		if ((command == PROFILE_MESSAGE) &&
+				args.has(1) && (args[0] < MAX_PHASES)) {
+			sendProfileReply(args[0], args.has(2) && (args[1] & PROFILE_RESET));
+			return true;
+		}
+		return Tile::handleSysexSpan(command, args);
+	}
+#endif
+
+	byte getSupportedFeatures() {
+		return Tile::getSupportedFeatures() | FEATURE_TILE_CHANGE_FRAME;
+	}
+
+	byte getRows() {
+		return MAX_ROWS;
+	}
+
+	byte getColumns() {
+		return MAX_COLUMNS;
 	}
 
 	void onTileTypeMessageReceived(byte row, byte column, Tile::Type type) {
-		char str[24];
-		snprintf(str, 24, "(%d,%d)=%s", row, column,
-			(type == Tile::Type::WATER) ? "WATER" :
-			(type == Tile::Type::HIT) ? "HIT" :
-			(type == Tile::Type::DESTROYED) ? "DESTROYED" : "NONE");
-		Firmata.sendString(str);
-		// TODO: update ui
+		GAME_GRID_TRACE("(%d,%d)=%d", row, column, static_cast<int>(type));
 		setTile(row, column, type);
 	}
+
+	void onTileTypeBulkMessageReceived(byte row, byte column,
+			byte rows, byte columns, const byte * packedTypes) {
+		GAME_GRID_TRACE("(%d,%d)+(%d,%d)", row, column, rows, columns);
+		setTiles(row, column, rows, columns, packedTypes);
+	}
 };
 
 // Listeners
@@ -200,31 +726,176 @@ template<
 	typename RgbLedMatrix,
 	typename RgbLedPhotodiodeArray,
 	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
-	uint8_t FPS
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
 >
 typename AttackGrid<
 	RgbLedMatrix,
 	RgbLedPhotodiodeArray,
 	MAX_ROWS, MAX_COLUMNS,
-	FPS
+	FPS,
+	BITS_PER_COLOR
 >::OnSignalEdgeListenerMatrix AttackGrid<
 	RgbLedMatrix,
 	RgbLedPhotodiodeArray,
 	MAX_ROWS, MAX_COLUMNS,
-	FPS
+	FPS,
+	BITS_PER_COLOR
 >::onSignalEdgeListenerMatrix;
 
 template<
 	typename RgbLedMatrix,
 	typename RgbLedPhotodiodeArray,
 	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
-	uint8_t FPS
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
 >
 GameGrid::Tile::Type AttackGrid<
 	RgbLedMatrix,
 	RgbLedPhotodiodeArray,
 	MAX_ROWS, MAX_COLUMNS,
-	FPS
+	FPS,
+	BITS_PER_COLOR
 >::tiles[MAX_ROWS][MAX_COLUMNS] = { GameGrid::Tile::Type::WATER };
 
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+typename AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::Frame AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::frameBuffers[2] = { };
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+volatile uint8_t AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::frontFrame = 0;
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+volatile bool AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::swapPending = false;
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+bool AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::isDrawingPixels = false;
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+volatile uint8_t AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::pendingTileChanges[MAX_COLUMNS] = { 0x00 };
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+volatile uint8_t AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::frameCount = 0;
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+typename AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::ScanMode AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::scanMode = AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::ScanMode::POLLING;
+
+#ifdef ATTACK_GRID_PROFILE
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+TimingStats AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::phaseStats[MAX_PHASES];
+#endif
+
 #endif // ATTACK_GRID_H
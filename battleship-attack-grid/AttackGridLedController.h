@@ -0,0 +1,102 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ATTACK_GRID_LED_CONTROLLER_H
+#define ATTACK_GRID_LED_CONTROLLER_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <stdint.h>
+
+/// <summary>
+/// FastLED controller for the LED matrix of the AttackGrid. Each show()
+/// converts the pixels into the bit planes of the back frame of the grid at
+/// once, which is then shown with binary code modulation by the scan of the
+/// grid from the next frame boundary on. Thus the scan itself never touches
+/// a pixel, while the color utilities and the brightness of FastLED can be
+/// used, e.g.:
+///
+///   CRGB leds[LED_MATRIX_ROWS * LED_MATRIX_COLUMNS];
+///   AttackGridLedController<decltype(attackGrid)> ledController;
+///   FastLED.addLeds(&ledController, leds, sizeof(leds) / sizeof(leds[0]));
+///
+/// The pixels are given in row-major order and only shown on untouched
+/// tiles, without red as it senses them. Temporal dithering of FastLED adds
+/// depth beyond the BITS_PER_COLOR of the grid over several shows.
+/// </summary>
+template<
+	typename AttackGrid,
+	uint8_t MAX_ROWS = 8, uint8_t MAX_COLUMNS = 8,
+	EOrder RGB_ORDER = RGB
+>
+class AttackGridLedController : public CPixelLEDController<RGB_ORDER> {
+
+protected:
+	virtual void init() { }
+
+	virtual void showPixels(PixelController<RGB_ORDER> & pixels) {
+		AttackGrid::beginPixels();
+		for (uint8_t row = 0; row < MAX_ROWS; row++) {
+			for (uint8_t column = 0; column < MAX_COLUMNS; column++) {
+				if (!pixels.has(1)) {
+					break;
+				}
+				AttackGrid::setPixel(row, column,
+					pixels.loadAndScale0(),
+					pixels.loadAndScale1(),
+					pixels.loadAndScale2()
+				);
+				pixels.advanceData();
+				pixels.stepDithering();
+			}
+		}
+		AttackGrid::endPixels();
+	}
+};
+
+#endif // ATTACK_GRID_LED_CONTROLLER_H
@@ -52,9 +52,22 @@
 #include <Arduino.h>
 #include <ConfigurableFirmata.h>
 #include <FirmataFeature.h>
+#include <Encoder7Bit.h>
 #include <stdio.h>
 #include <stdint.h>
 
+// Define GAME_GRID_DEBUG to trace the received messages as Firmata strings.
+// It is compiled out by default as it multiplies the outbound traffic.
+#ifdef GAME_GRID_DEBUG
+#define GAME_GRID_TRACE(format, ...) do { \
+		char str[32]; \
+		snprintf(str, sizeof(str), format, __VA_ARGS__); \
+		Firmata.sendString(str); \
+	} while (0)
+#else
+#define GAME_GRID_TRACE(format, ...) do { } while (0)
+#endif
+
 struct GameGrid {
 
 	static const byte MAX_ROWS = 8;
@@ -66,12 +79,74 @@ struct GameGrid {
 	/// HID device driver to receive messages from the remote computer.
 	/// GameGrid::Tile::sendTileChangeMessage can be used to report tile change
 	/// info back to the remote computer.
+	/// GameGrid::Tile::sendTileChangeFrameMessage reports all tile changes of
+	/// a frame at once instead, if the remote computer has opted in via the
+	/// GRID_CONFIG_MESSAGE.
 	/// </summary>
 	struct Tile : public FirmataFeature {
 
 		static const byte INVALID_VALUE = INT8_MAX;
 		static const byte TILE_TYPE_MESSAGE = 0x0F;
 		static const byte TILE_CHANGE_MESSAGE = 0x0E;
+		static const byte TILE_CHANGE_FRAME_MESSAGE = 0x0B;
+		static const byte GRID_CONFIG_MESSAGE = 0x0A;
+		static const byte TILE_TYPE_BULK_MESSAGE = 0x09;
+		static const byte TILE_TYPE_ACK_MESSAGE = 0x08;
+
+		/// <summary>
+		/// Sizes of the reports sent by sendTileChangeMessage() and
+		/// sendTileChangeFrameMessage(), including the sysex framing.
+		/// </summary>
+		enum TileChangeBytes {
+			TILE_CHANGE_BYTES       = 5,
+			TILE_CHANGE_FRAME_BYTES = 4 + (MAX_COLUMNS * 8 + 6) / 7,
+		};
+
+		/// <summary>
+		/// Layout of the TILE_TYPE_BULK_MESSAGE:
+		/// 0xF0 0x09 row column rows columns types... 0xF7
+		/// The types of the rectangle are given in row-major order, packed
+		/// with TYPE_BITS each, TYPES_PER_BYTE per 7-bit byte starting with
+		/// the least significant bits.
+		/// </summary>
+		enum TileTypeBulk {
+			TILE_TYPE_BULK_HEADER_BYTES = 4,
+			TYPE_BITS                   = 2,
+			TYPE_MASK                   = (1 << TYPE_BITS) - 1,
+			TYPES_PER_BYTE              = 7 / TYPE_BITS,
+		};
+
+		// The parser must hold the command and arguments of a whole grid.
+		static_assert(1 + TILE_TYPE_BULK_HEADER_BYTES +
+			(MAX_ROWS * MAX_COLUMNS + TYPES_PER_BYTE - 1) / TYPES_PER_BYTE
+			<= MAX_DATA_BYTES,
+			"MAX_DATA_BYTES is too small for a bulk upload of the grid");
+
+		/// <summary>
+		/// Subcommands of the GRID_CONFIG_MESSAGE:
+		/// QUERY:        0xF0 0x0A 0x00 0xF7
+		/// SET_FEATURES: 0xF0 0x0A 0x01 features 0xF7
+		/// Both are answered with
+		/// REPLY:        0xF0 0x0A 0x02 supported enabled 0xF7
+		/// </summary>
+		enum GridConfig {
+			GRID_CONFIG_QUERY        = 0x00,
+			GRID_CONFIG_SET_FEATURES = 0x01,
+			GRID_CONFIG_REPLY        = 0x02,
+		};
+
+		/// <summary>
+		/// Optional protocol features as bitfield. All of them are disabled
+		/// after a reset, so remote computers that do not know them keep on
+		/// working.
+		/// </summary>
+		enum Feature {
+			// Report TILE_CHANGE_FRAME_MESSAGE instead of TILE_CHANGE_MESSAGE.
+			FEATURE_TILE_CHANGE_FRAME = 0x01,
+			// Acknowledge each applied tile type message with a
+			// TILE_TYPE_ACK_MESSAGE: 0xF0 0x08 sequence command 0xF7
+			FEATURE_TILE_TYPE_ACK     = 0x02,
+		};
 
 		enum class Type {
 			NONE = 0x00,
@@ -81,29 +156,108 @@ struct GameGrid {
 			SELECTED = 0x04 // Extra state not sent to pc. 
 		};
 
-		boolean handlePinMode(byte pin, int mode) { }
+		boolean handlePinMode(byte pin, int mode) { return false; }
 		void handleCapability(byte pin) { }
 
 		static bool shouldReset;// = false;
+		static byte enabledFeatures;// = 0x00;
+		static byte ackSequence;// = 0;
 		//virtual void reset() = 0; // Does not work here as pure virtual! Why?
 		void reset() {
 			shouldReset = true;
+			enabledFeatures = 0x00;
+			ackSequence = 0;
 		};
 
+		static bool isFeatureEnabled(Feature feature) {
+			return (enabledFeatures & feature) != 0;
+		}
+
+		/// <summary>
+		/// Claim the grid messages so they are routed here directly.
+		/// </summary>
+		boolean handlesSysexCommand(byte command) {
+			return (command == TILE_TYPE_MESSAGE) ||
+				(command == GRID_CONFIG_MESSAGE) ||
+				(command == TILE_TYPE_BULK_MESSAGE);
+		}
 
 		boolean handleSysex(byte command, byte argc, byte *argv) {
-			if ((command == TILE_TYPE_MESSAGE) && (argc >= 3)) {
-				byte item = argv[0];
-				byte row = argv[1];
-				byte column = argv[2];
+			return handleSysexSpan(command, SysexSpan(argv, argc));
+		}
+
+		boolean handleSysexSpan(byte command, SysexSpan args) {
+			if ((command == TILE_TYPE_MESSAGE) && args.has(3)) {
+				byte item = args[0];
+				byte row = args[1];
+				byte column = args[2];
+				if (!isOnGrid(row, column, 1, 1) ||
+						(item > static_cast<byte>(Tile::Type::SELECTED))) {
+					return false;
+				}
 				onTileTypeMessageReceived(
 					row, column, static_cast<Tile::Type>(item)
 				);
+				sendTileTypeAckMessage(command);
+				return true;
+			}
+			if ((command == GRID_CONFIG_MESSAGE) && args.has(1)) {
+				if ((args[0] == GRID_CONFIG_SET_FEATURES) && args.has(2)) {
+					enabledFeatures = args[1] & getSupportedFeatures();
+				} else if (args[0] != GRID_CONFIG_QUERY) {
+					return false;
+				}
+				sendGridConfigReply();
+				return true;
+			}
+			if ((command == TILE_TYPE_BULK_MESSAGE) &&
+					args.has(TILE_TYPE_BULK_HEADER_BYTES)) {
+				const byte row = args[0];
+				const byte column = args[1];
+				const byte rows = args[2];
+				const byte columns = args[3];
+				const byte typeBytes =
+					((rows * columns) + TYPES_PER_BYTE - 1) / TYPES_PER_BYTE;
+				if (!isOnGrid(row, column, rows, columns) ||
+						!args.has(TILE_TYPE_BULK_HEADER_BYTES + typeBytes)) {
+					return false;
+				}
+				onTileTypeBulkMessageReceived(row, column, rows, columns,
+					args.subspan(TILE_TYPE_BULK_HEADER_BYTES).data());
+				sendTileTypeAckMessage(command);
 				return true;
 			}
 			return false;
 		}
 
+		/// <summary>
+		/// Override this method to announce the optional protocol features
+		/// implemented by the HID device driver in addition to these.
+		/// </summary>
+		virtual byte getSupportedFeatures() {
+			return FEATURE_TILE_TYPE_ACK;
+		}
+
+		/// <summary>
+		/// Override these methods if the grid of the HID device driver is
+		/// smaller than MAX_ROWS x MAX_COLUMNS.
+		/// </summary>
+		virtual byte getRows() {
+			return MAX_ROWS;
+		}
+
+		virtual byte getColumns() {
+			return MAX_COLUMNS;
+		}
+
+		/// <summary>
+		/// Check whether a rectangle of tiles lies within the grid.
+		/// </summary>
+		bool isOnGrid(byte row, byte column, byte rows, byte columns) {
+			return (row + rows <= getRows()) &&
+				(column + columns <= getColumns());
+		}
+
 		/// <summary>
 		/// Implemented this method to receive tile type messages from the
 		/// remote computer.
@@ -111,6 +265,33 @@ struct GameGrid {
 		virtual void onTileTypeMessageReceived(
 			byte row, byte column, Tile::Type type) = 0;
 
+		/// <summary>
+		/// Override this method to apply a rectangle of tile types at once.
+		/// By default each tile is passed to onTileTypeMessageReceived.
+		/// </summary>
+		virtual void onTileTypeBulkMessageReceived(byte row, byte column,
+				byte rows, byte columns, const byte * packedTypes) {
+			byte index = 0;
+			for (byte r = row; r < row + rows; r++) {
+				for (byte c = column; c < column + columns; c++) {
+					onTileTypeMessageReceived(
+						r, c, getPackedTileType(packedTypes, index++)
+					);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Unpack the tile type at the given index of a bulk message.
+		/// </summary>
+		static Tile::Type getPackedTileType(
+				const byte * packedTypes, byte index) {
+			const byte shift = (index % TYPES_PER_BYTE) * TYPE_BITS;
+			return static_cast<Tile::Type>(
+				(packedTypes[index / TYPES_PER_BYTE] >> shift) & TYPE_MASK
+			);
+		}
+
 		/// <summary>
 		/// Report tile change messages back to the remote computer.
 		/// </summary>
@@ -121,9 +302,55 @@ struct GameGrid {
 			Firmata.write(column % MAX_COLUMNS);
 			Firmata.write(END_SYSEX);
 		}
+
+		/// <summary>
+		/// Report all tile changes of a frame back to the remote computer.
+		/// The 64-bit bitmap holds one byte per column with a bit per row and
+		/// is sent 7-bit encoded, followed by a 7-bit frame counter.
+		/// </summary>
+		static void sendTileChangeFrameMessage(
+				const byte changedRows[MAX_COLUMNS], byte frame) {
+			Firmata.write(START_SYSEX);
+			Firmata.write(TILE_CHANGE_FRAME_MESSAGE);
+			Encoder7Bit.startBinaryWrite();
+			for (byte column = 0; column < MAX_COLUMNS; column++) {
+				Encoder7Bit.writeBinary(changedRows[column]);
+			}
+			Encoder7Bit.endBinaryWrite();
+			Firmata.write(frame & 0x7F);
+			Firmata.write(END_SYSEX);
+		}
+
+	private:
+		/// <summary>
+		/// Acknowledge an applied tile type message if the remote computer
+		/// has opted in. The 7-bit sequence number restarts on reset.
+		/// </summary>
+		static void sendTileTypeAckMessage(byte command) {
+			if (!isFeatureEnabled(FEATURE_TILE_TYPE_ACK)) {
+				return;
+			}
+			Firmata.write(START_SYSEX);
+			Firmata.write(TILE_TYPE_ACK_MESSAGE);
+			Firmata.write(ackSequence);
+			Firmata.write(command);
+			Firmata.write(END_SYSEX);
+			ackSequence = (ackSequence + 1) & 0x7F;
+		}
+
+		void sendGridConfigReply() {
+			Firmata.write(START_SYSEX);
+			Firmata.write(GRID_CONFIG_MESSAGE);
+			Firmata.write(GRID_CONFIG_REPLY);
+			Firmata.write(getSupportedFeatures());
+			Firmata.write(enabledFeatures);
+			Firmata.write(END_SYSEX);
+		}
 	};
 };
 
 bool GameGrid::Tile::shouldReset = false;
+byte GameGrid::Tile::enabledFeatures = 0x00;
+byte GameGrid::Tile::ackSequence = 0;
 
 #endif // GAME_GRID_H
\ No newline at end of file
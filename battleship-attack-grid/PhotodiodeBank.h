@@ -0,0 +1,167 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PHOTODIODE_BANK_H
+#define PHOTODIODE_BANK_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/// <summary>
+/// Comparators of the photodiodes of one column. The tresholds and logic
+/// levels of all rows are packed together, such that a column is evaluated
+/// in a single pass without branches and edges are reported as bitmasks.
+/// </summary>
+template<uint8_t ROWS = 8>
+class PhotodiodeBank {
+
+	static_assert(ROWS >= 1 && ROWS <= 8,
+		"A bank reports its rows as an 8-bit mask.");
+
+public:
+	struct OnSignalEdgeListener {
+		virtual ~OnSignalEdgeListener() { }
+		virtual void onRaisingSignalEdges(uint8_t column, uint8_t rows) = 0;
+		virtual void onFallingSignalEdges(uint8_t column, uint8_t rows) = 0;
+	};
+
+	/// <summary>
+	/// Calibrated readings of a photodiode in the dark and when lit.
+	/// </summary>
+	struct Calibration {
+		uint16_t min;
+		uint16_t max;
+	};
+
+	enum : uint16_t {
+		// Readings are 10-bit wide as provided by the MCP3008.
+		READING_MAX           = 0x3FF,
+		HYSTERESIS_PERCENTAGE = 10,
+	};
+
+private:
+	uint16_t negativeTresholds[ROWS];
+	uint16_t positiveTresholds[ROWS];
+	uint8_t logicLevels;
+	OnSignalEdgeListener * onSignalEdgeListener;
+
+public:
+
+	PhotodiodeBank() {
+		for (uint8_t row = 0; row < ROWS; row++) {
+			setTreshold(row, 0, READING_MAX, HYSTERESIS_PERCENTAGE);
+		}
+		logicLevels = 0x00;
+		onSignalEdgeListener = nullptr;
+	}
+
+	PhotodiodeBank(const Calibration (&calibrations)[ROWS],
+			uint8_t hysteresisPercentage = HYSTERESIS_PERCENTAGE) {
+		for (uint8_t row = 0; row < ROWS; row++) {
+			setTreshold(row, calibrations[row].min, calibrations[row].max,
+				hysteresisPercentage);
+		}
+		logicLevels = 0x00;
+		onSignalEdgeListener = nullptr;
+	}
+
+	/// <summary>
+	/// Precompute the comparator tresholds from the calibrated readings. The
+	/// hysteresis band is rounded to the nearest reading in fixed-point.
+	/// </summary>
+	void setTreshold(uint8_t row, uint16_t min, uint16_t max,
+			uint8_t hysteresisPercentage = HYSTERESIS_PERCENTAGE) {
+		const uint16_t difference = max - min;
+		const uint16_t treshold = (difference / 2) + min;
+		const uint16_t band = (
+			static_cast<uint32_t>(difference) * hysteresisPercentage + 50
+		) / 100;
+		negativeTresholds[row] = treshold - band;
+		positiveTresholds[row] = treshold + band;
+	}
+
+	void setOnSignalEdgeListener(OnSignalEdgeListener * onSignalEdgeListener) {
+		this->onSignalEdgeListener = onSignalEdgeListener;
+	}
+
+	/// <summary>
+	/// Report the logic levels of the photodiode light intensities as a
+	/// bitmask of rows. I.e. if the light level is high or if not.
+	/// The model used represents crude non inverting comparators with
+	/// hysteresis to compensate signal noise. It also invokes the
+	/// OnSignalEdgeListener at most once per edge direction.
+	/// </summary>
+	uint8_t getLogicOutputsWithHysteresis(
+			uint8_t column, const uint16_t (&newReadings)[ROWS]) {
+		uint8_t aboveTresholds = 0x00;
+		uint8_t belowTresholds = 0x00;
+		uint8_t rowMask = 0x01;
+		for (uint8_t row = 0; row < ROWS; row++) {
+			// Turn each comparison into 0x00 or 0xFF to avoid branching.
+			aboveTresholds |= rowMask & -static_cast<uint8_t>(
+				newReadings[row] > positiveTresholds[row]);
+			belowTresholds |= rowMask & -static_cast<uint8_t>(
+				newReadings[row] < negativeTresholds[row]);
+			rowMask <<= 1;
+		}
+		const uint8_t raisingEdges = ~logicLevels & aboveTresholds;
+		const uint8_t fallingEdges = logicLevels & belowTresholds;
+		logicLevels = (logicLevels | raisingEdges) & ~fallingEdges;
+		if (onSignalEdgeListener != nullptr) {
+			if (raisingEdges) {
+				onSignalEdgeListener->onRaisingSignalEdges(column, raisingEdges);
+			}
+			if (fallingEdges) {
+				onSignalEdgeListener->onFallingSignalEdges(column, fallingEdges);
+			}
+		}
+		return logicLevels;
+	}
+};
+
+#endif // PHOTODIODE_BANK_H
@@ -63,7 +63,43 @@ class RgbLedMatrix {
 
 	static SpiDevice spiDevice;
 
+	enum {
+		COLUMN_REGISTERS = 4, // Red, green, blue and column shift registers.
+	};
+
+	// Column that is shifted by shiftColumn() until it is latched.
+	static uint8_t shiftedColumn[COLUMN_REGISTERS];
+
+	/// <summary>
+	/// Calculate the register contents of a column for a common cathode RGB
+	/// LED matrix.
+	/// </summary>
+	static void encodeColumn(uint8_t (&data)[COLUMN_REGISTERS],
+			uint8_t rowReds, uint8_t rowGreens, uint8_t rowBlues,
+			uint8_t column) {
+		// The order of the bytes depends on the positioning of the daisy
+		// chained shift registers. In this case the first shift register is
+		// responsable for the red LEDs, the 2nd for the green LEDs, and the 3rd
+		// for the blue LEDs. Finally the is the last register for the selection
+		// of the active column. Since the column register is the last one in
+		// the chain it must be transmitted as the first byte following the
+		// other bytes until it propagates through all the shift registers.
+		data[0] = (uint8_t)(1 << column); // Activate given row NMOS transistor.
+		data[1] = ~rowBlues;  // Flip bits to activate PMOS transistors.
+		data[2] = ~rowGreens; // Flip bits to activate PMOS transistors.
+		data[3] = ~rowReds;   // Flip bits to activate PMOS transistors.
+	}
+
 public:
+	typedef typename SpiDevice::Bus Bus;
+
+	/// <summary>
+	/// Estimated duration of writeColumn() in microseconds.
+	/// </summary>
+	static constexpr uint32_t writeColumnMicros() {
+		return SpiDevice::transferMicros(COLUMN_REGISTERS);
+	}
+
 	/// <summary>
 	/// Initalize matrix.
 	/// </summary>
@@ -71,6 +107,13 @@ public:
 		spiDevice.master();
 	}
 
+	/// <summary>
+	/// Declare that the matrix is refreshed from within an interrupt.
+	/// </summary>
+	static void usingInterrupt() {
+		spiDevice.usingInterrupt();
+	}
+
 	/// <summary>
 	/// Write the row colors to the selected column. The enabled color for each
 	/// row is encoded as a bitfield.
@@ -78,21 +121,48 @@ public:
 	static void writeColumn(
 			uint8_t rowReds, uint8_t rowGreens, uint8_t rowBlues,
 			uint8_t column) {
-		// Calculate register contents for a common cathode RGB LED matrix.
-		rowReds   = ~rowReds;   // Flip bits to activate PMOS transistors.
-		rowGreens = ~rowGreens; // Flip bits to activate PMOS transistors.
-		rowBlues  = ~rowBlues;  // Flip bits to activate PMOS transistors.
-		column = (uint8_t)(1 << column); // Activate given row NMOS transistor.
-		// The order of the bytes depends on the positioning of the daisy
-		// chained shift registers. In this case the first shift register is
-		// responsable for the red LEDs, the 2nd for the green LEDs, and the 3rd
-		// for the blue LEDs. Finally the is the last register for the selection
-		// of the active column. Since the column register is the last one in
-		// the chain it must be transmitted as the first byte following the
-		// other bytes until it propagates through all the shift registers.
-		uint8_t data[] = { column, rowBlues, rowGreens, rowReds };
+		uint8_t data[COLUMN_REGISTERS];
+		encodeColumn(data, rowReds, rowGreens, rowBlues, column);
 		spiDevice.transferBulk(data, sizeof(data));
 	}
+
+	/// <summary>
+	/// Shift the row colors of a column into the registers like writeColumn()
+	/// but return before they have been shifted, and keep showing the column
+	/// that has been latched before. Requires a bus of its own, see
+	/// SpiDeviceUsart0::beginFrame().
+	/// </summary>
+	static void shiftColumn(
+			uint8_t rowReds, uint8_t rowGreens, uint8_t rowBlues,
+			uint8_t column) {
+		encodeColumn(shiftedColumn, rowReds, rowGreens, rowBlues, column);
+		spiDevice.beginFrame(shiftedColumn, sizeof(shiftedColumn));
+	}
+
+	/// <summary>
+	/// Keep shifting the column begun by shiftColumn(), without waiting.
+	/// </summary>
+	static void continueColumn() {
+		spiDevice.continueFrame();
+	}
+
+	/// <summary>
+	/// Wait until the column begun by shiftColumn() has been shifted, it is
+	/// still not shown.
+	/// </summary>
+	static void flushColumn() {
+		spiDevice.flushFrame();
+	}
+
+	/// <summary>
+	/// Show the column begun by shiftColumn() once it has been shifted.
+	/// </summary>
+	static void latchColumn() {
+		spiDevice.endFrame();
+	}
 };
 
+template<typename SpiDevice>
+uint8_t RgbLedMatrix<SpiDevice>::shiftedColumn[COLUMN_REGISTERS];
+
 #endif // RGB_LED_MATRIX_H
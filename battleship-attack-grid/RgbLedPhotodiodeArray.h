@@ -62,15 +62,61 @@ class RgbLedPhotodiodeArray {
 	static SpiDevice spiDevice;
 
 	enum MCP3008Configuration {
-		// Use all 8 channels @ 8-bits. Do not care for 10 bit resolution.
-		MCP3008_START_BIT            = (1 << 6),
-		MCP3008_SINGLE_NOT_DIFF_CONV = (1 << 5),
-		MCP3008_CHANNEL_MAX          = 8,
-		MCP3008_CHANNEL_LSHIFT       = 2,
-		MCP3008_DUMMY_BYTE           = 0x00
+		// 8-bit framing: two bytes per channel, the second returns B9..B2.
+		MCP3008_START_BIT              = (1 << 6),
+		MCP3008_SINGLE_NOT_DIFF_CONV   = (1 << 5),
+		MCP3008_CHANNEL_MAX            = 8,
+		MCP3008_CHANNEL_LSHIFT         = 2,
+		MCP3008_DUMMY_BYTE             = 0x00,
+		MCP3008_FRAME_BYTES            = 2,
+		// 10-bit framing: three byte aligned, the last two return B9..B0.
+		MCP3008_FRAME10_START_BYTE     = 0x01,
+		MCP3008_FRAME10_SINGLE_CONV    = (1 << 7),
+		MCP3008_FRAME10_CHANNEL_LSHIFT = 4,
+		MCP3008_FRAME10_MSB_MASK       = 0x03,
+		MCP3008_FRAME10_BYTES          = 3
 	};
 
+	static void writeFrame(uint8_t frame[MCP3008_FRAME_BYTES],
+			uint8_t channel) {
+		frame[0] =
+			MCP3008_START_BIT |
+			MCP3008_SINGLE_NOT_DIFF_CONV |
+			(channel << MCP3008_CHANNEL_LSHIFT);
+		frame[1] = MCP3008_DUMMY_BYTE;
+	}
+
+	static void writeFrame10(uint8_t frame[MCP3008_FRAME10_BYTES],
+			uint8_t channel) {
+		frame[0] = MCP3008_FRAME10_START_BYTE;
+		frame[1] =
+			MCP3008_FRAME10_SINGLE_CONV |
+			(channel << MCP3008_FRAME10_CHANNEL_LSHIFT);
+		frame[2] = MCP3008_DUMMY_BYTE;
+	}
+
+	static uint16_t readFrame10(const uint8_t frame[MCP3008_FRAME10_BYTES]) {
+		return ((frame[1] & MCP3008_FRAME10_MSB_MASK) << 8) | frame[2];
+	}
+
 public:
+	typedef typename SpiDevice::Bus Bus;
+
+	/// <summary>
+	/// Estimated duration of reading all photodiodes in microseconds.
+	/// </summary>
+	static constexpr uint32_t readMicros() {
+		return SpiDevice::transferMicros(2, MCP3008_CHANNEL_MAX);
+	}
+
+	/// <summary>
+	/// Estimated duration of reading all photodiodes at 10-bit resolution in
+	/// microseconds.
+	/// </summary>
+	static constexpr uint32_t read10Micros() {
+		return SpiDevice::transferMicros(3, MCP3008_CHANNEL_MAX);
+	}
+
 	/// <summary>
 	/// Initalize sensor and perform software reset.
 	/// </summary>
@@ -80,14 +126,16 @@ public:
 		read(dummyByte, sizeof(dummyByte));
 	}
 
-	static void mcp3008Config(uint8_t channel, uint8_t data[2]) {
-		const uint8_t confByte = 0x60 | (channel << 2);
-		data[0] = confByte;
-		data[1] = 0x00;
+	/// <summary>
+	/// Declare that the sensor is read from within an interrupt.
+	/// </summary>
+	static void usingInterrupt() {
+		spiDevice.usingInterrupt();
 	}
 
 	/// <summary>
-	/// Reads the red LEDs as photodiodes.
+	/// Reads the red LEDs as photodiodes. All channels are converted in a
+	/// single SPI transaction and only slave select is toggled in between.
 	/// </summary>
 	/// <param name="diodes">
 	/// Array of data bytes to be read. Its content will be overwritten by the
@@ -100,13 +148,106 @@ public:
 	/// The actual number of read photodiodes.
 	/// </returns>
 	static uint8_t read(uint8_t * /*[out]*/ diodes, uint8_t length) {
-		for (uint8_t i = 0; i < MCP3008_CHANNEL_MAX; i++) {
-			static uint8_t data[2];
-			mcp3008Config(i, data);
-			spiDevice.transferBulk(data, sizeof(data));
-			diodes[i] = data[1];
+		const uint8_t MAX_ITEMS = min(length, MCP3008_CHANNEL_MAX);
+#ifdef ARDUINO
+		// On the AVR a frame is converted at a time, so no array of all frames
+		// adds to the stack of the timer interrupt that reads the sensor.
+		spiDevice.beginTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			uint8_t frame[MCP3008_FRAME_BYTES];
+			writeFrame(frame, i);
+			spiDevice.transferFrame(frame, sizeof(frame));
+			diodes[i] = frame[1];
+		}
+		spiDevice.endTransaction();
+#else
+		uint8_t frames[MCP3008_CHANNEL_MAX][MCP3008_FRAME_BYTES];
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			writeFrame(frames[i], i);
+		}
+		spiDevice.beginTransaction();
+		spiDevice.transferFrames(frames[0], MCP3008_FRAME_BYTES, MAX_ITEMS);
+		spiDevice.endTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			diodes[i] = frames[i][1];
+		}
+#endif
+		return MAX_ITEMS;
+	}
+
+	/// <summary>
+	/// Reads the red LEDs as photodiodes at the full 10-bit resolution. All
+	/// channels are converted in a single SPI transaction.
+	/// </summary>
+	/// <param name="diodes">
+	/// Array of data words to be read. Its content will be overwritten by the
+	/// sensed values.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	/// <returns>
+	/// The actual number of read photodiodes.
+	/// </returns>
+	static uint8_t read(uint16_t * /*[out]*/ diodes, uint8_t length) {
+		const uint8_t MAX_ITEMS = min(length, MCP3008_CHANNEL_MAX);
+#ifdef ARDUINO
+		// On the AVR a frame is converted at a time, so no array of all frames
+		// adds to the stack of the timer interrupt that reads the sensor.
+		spiDevice.beginTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			uint8_t frame[MCP3008_FRAME10_BYTES];
+			writeFrame10(frame, i);
+			spiDevice.transferFrame(frame, sizeof(frame));
+			diodes[i] = readFrame10(frame);
+		}
+		spiDevice.endTransaction();
+#else
+		uint8_t frames[MCP3008_CHANNEL_MAX][MCP3008_FRAME10_BYTES];
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			writeFrame10(frames[i], i);
+		}
+		spiDevice.beginTransaction();
+		spiDevice.transferFrames(frames[0], MCP3008_FRAME10_BYTES, MAX_ITEMS);
+		spiDevice.endTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			diodes[i] = readFrame10(frames[i]);
+		}
+#endif
+		return MAX_ITEMS;
+	}
+
+	/// <summary>
+	/// Reads the red LEDs as photodiodes at the full 10-bit resolution like
+	/// read(), but one channel after the other and a function is called after
+	/// each conversion, e.g. to keep a device on another bus busy meanwhile.
+	/// </summary>
+	/// <param name="diodes">
+	/// Array of data words to be read. Its content will be overwritten by the
+	/// sensed values.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	/// <param name="onConversion">
+	/// Called after each conversion.
+	/// </param>
+	/// <returns>
+	/// The actual number of read photodiodes.
+	/// </returns>
+	static uint8_t read(uint16_t * /*[out]*/ diodes, uint8_t length,
+			void (*onConversion)()) {
+		const uint8_t MAX_ITEMS = min(length, MCP3008_CHANNEL_MAX);
+		spiDevice.beginTransaction();
+		for (uint8_t i = 0; i < MAX_ITEMS; i++) {
+			uint8_t frame[MCP3008_FRAME10_BYTES];
+			writeFrame10(frame, i);
+			spiDevice.transferFrame(frame, sizeof(frame));
+			diodes[i] = readFrame10(frame);
+			onConversion();
 		}
-		MCP3008_CHANNEL_MAX;
+		spiDevice.endTransaction();
+		return MAX_ITEMS;
 	}
 };
 
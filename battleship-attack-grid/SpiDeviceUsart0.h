@@ -0,0 +1,338 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science 
+ * at the Free University of Bozen-Bolzano.
+ * 
+ *                                                                         
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t  
+ *                                                                         
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *                                                                         
+ *                  8                                                      
+ *                  8                                                      
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo. 
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8 
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .  
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo' 
+ *                                             8                           
+ *                                             8                           
+ *                                                                         
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *                                                                         
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y 
+ *                                                                         
+ *                                                                         
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPI_DEVICE_USART0_H
+#define SPI_DEVICE_USART0_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include <SpiDevice.h>
+
+/// <summary>
+/// State of USART0 as SPI bus shared by all devices on it.
+/// </summary>
+struct SpiDeviceUsart0Bus {
+
+	static bool & isUsedInInterrupt() {
+		static bool isUsedInInterrupt = false;
+		return isUsedInInterrupt;
+	}
+
+	static uint8_t & interruptSave() {
+		static uint8_t interruptSave = 0;
+		return interruptSave;
+	}
+
+	// Bytes of the frame begun by beginFrame() that are still to be written.
+	static const uint8_t *& pendingData() {
+		static const uint8_t * pendingData = NULL;
+		return pendingData;
+	}
+
+	static uint8_t & pendingLength() {
+		static uint8_t pendingLength = 0;
+		return pendingLength;
+	}
+
+	static bool & isShifting() {
+		static bool isShifting = false;
+		return isShifting;
+	}
+};
+
+/// <summary>
+/// SPI driver on USART0 of the Arduino Uno in master SPI mode, a second bus
+/// besides the SPI, e.g. such that a device can be written while another one
+/// is read on the SPI. It has the interface of SpiDevicePortB.
+/// Limits:
+/// - USART0 is the serial port of the Uno, i.e. of the USB bridge. It cannot
+///   be used together with Serial and thereby Firmata, the host link must be
+///   moved elsewhere, e.g. to a board with a second USART.
+/// - SCK is XCK0 on digital pin 4, MOSI is TXD on pin 1 and MISO is RXD on
+///   pin 0. Slave select is still a pin of PORTB.
+/// - SCK is F_CPU / (2 * (UBRR0 + 1)), the fastest one that does not exceed
+///   F_SCK is used. Unlike the SPI, it can be any even divider of F_CPU.
+/// - There is no slave mode and no SS pin of its own.
+/// The transmit buffer is filled while the previous byte is shifted, so
+/// the bytes of a frame follow each other without a gap. A frame to a write
+/// only device can also be shifted in the background with beginFrame(),
+/// while the CPU serves a device on the SPI.
+/// </summary>
+template<
+	uint8_t PORTB_PIN,
+	uint32_t F_SCK = 4000000/*Hz*/,
+	SpiBitOrder BIT_ORDER = SpiBitOrderMsbFirst,
+	SpiMode MODE = SpiMode0
+>
+struct SpiDeviceUsart0 {
+
+	typedef SpiDeviceUsart0Bus Bus;
+
+	enum UsartRegisters {
+		UBRR_VALUE = (F_CPU + 2 * F_SCK - 1) / (2 * F_SCK) - 1,
+		UCSR0C_VALUE = (1 << UMSEL01) | (1 << UMSEL00)
+			| ((BIT_ORDER == SpiBitOrderLsbFirst) ? (1 << UDORD0) : 0)
+			| ((MODE & (1 << CPHA)) ? (1 << UCPHA0) : 0)
+			| ((MODE & (1 << CPOL)) ? (1 << UCPOL0) : 0),
+		PIN_XCK0 = PD4,
+	};
+
+	static_assert(F_SCK <= F_CPU / 2,
+		"USART0 shifts at most at F_CPU / 2.");
+	static_assert(UBRR_VALUE <= 0x0FFF,
+		"F_SCK is too low for the 12-bit UBRR0.");
+
+	enum TimingModel {
+		// Cycles spent per byte besides shifting, none but a margin as the
+		// next byte is buffered while the current one is shifted.
+		BYTE_OVERHEAD_CYCLES        = 2,
+		// Cycles spent per frame to toggle the slave select pin.
+		FRAME_OVERHEAD_CYCLES       = 8,
+		// Time spent to begin and end a transaction including slave select.
+		TRANSACTION_OVERHEAD_MICROS = 2,
+	};
+
+	/// <summary>
+	/// Estimated duration of a transaction of frames in microseconds, i.e. of
+	/// transferBulk() for a single frame. It is used to verify timing budgets
+	/// at compile time like SpiDevicePortB::transferMicros().
+	/// </summary>
+	static constexpr uint32_t transferMicros(uint8_t length,
+		uint8_t frames = 1) {
+		return (frames * (length * (16UL * (UBRR_VALUE + 1)
+			+ BYTE_OVERHEAD_CYCLES) + FRAME_OVERHEAD_CYCLES)
+			+ (F_CPU / 1000000UL) - 1) / (F_CPU / 1000000UL)
+			+ TRANSACTION_OVERHEAD_MICROS;
+	}
+
+	/// <summary>
+	/// Initalize USART0 as SPI bus master. The baud rate register must be
+	/// zero while the mode is set, see the datasheet of the ATmega328P.
+	/// </summary>
+	static void master(void) {
+		PORTB |= (1 << PORTB_PIN);
+		DDRB |= (1 << PORTB_PIN);
+		UBRR0H = 0;
+		UBRR0L = 0;
+		DDRD |= (1 << PIN_XCK0);
+		UCSR0C = UCSR0C_VALUE;
+		UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+		UBRR0H = UBRR_VALUE >> 8;
+		UBRR0L = UBRR_VALUE & 0xFF;
+	}
+
+	/// <summary>
+	/// Declare that the bus is used from within an interrupt service
+	/// routine. Transactions outside of it are then performed with interrupts
+	/// masked, such that the interrupt cannot corrupt them.
+	/// </summary>
+	static void usingInterrupt(void) {
+		SpiDeviceUsart0Bus::isUsedInInterrupt() = true;
+	}
+
+	/// <summary>
+	/// Begin a transaction with the settings of this device. Any number of
+	/// frames can be transfered until it is ended again.
+	/// </summary>
+	static void beginTransaction(void) {
+		if (SpiDeviceUsart0Bus::isUsedInInterrupt()) {
+			SpiDeviceUsart0Bus::interruptSave() = SREG;
+			cli();
+		}
+		UCSR0C = UCSR0C_VALUE;
+		UBRR0H = UBRR_VALUE >> 8;
+		UBRR0L = UBRR_VALUE & 0xFF;
+	}
+
+	/// <summary>
+	/// End a transaction begun by beginTransaction().
+	/// </summary>
+	static void endTransaction(void) {
+		if (SpiDeviceUsart0Bus::isUsedInInterrupt()) {
+			SREG = SpiDeviceUsart0Bus::interruptSave();
+		}
+	}
+
+	/// <summary>
+	/// Transfer one frame, i.e. bytes framed by slave select, within a
+	/// transaction. The next byte is written to the transmit buffer before
+	/// the current one is received, the receive buffer holds two bytes.
+	/// Slave select is deasserted after the last byte has been received,
+	/// i.e. when it has been shifted completely.
+	/// </summary>
+	/// <param name="data">
+	/// Array of data bytes to be transfered. The content will be sent in order
+	/// of the array. Its content will be overwritten by the received bytes.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	static void transferFrame(uint8_t* /*[in,out]*/ data, uint8_t length) {
+		PORTB &= ~(1 << PORTB_PIN);
+		if (length > 0) {
+			while (!(UCSR0A & (1 << UDRE0))) { }
+			UDR0 = data[0];
+			for (uint8_t i = 1; i < length; i++) {
+				const uint8_t out = data[i];
+				while (!(UCSR0A & (1 << UDRE0))) { }
+				UDR0 = out;
+				while (!(UCSR0A & (1 << RXC0))) { }
+				data[i - 1] = UDR0;
+			}
+			while (!(UCSR0A & (1 << RXC0))) { }
+			data[length - 1] = UDR0;
+		}
+		PORTB |= (1 << PORTB_PIN);
+	}
+
+	/// <summary>
+	/// Begin to shift a frame to a write only device, e.g. a chain of shift
+	/// registers, and return before it has been shifted. As many bytes as fit
+	/// into the transmit buffer are written at once, continueFrame() writes
+	/// the others. Slave select stays asserted until endFrame(), i.e. the
+	/// shift registers latch the frame only then. The receiver is disabled
+	/// meanwhile, which also flushes its buffer. No other device may use the
+	/// bus until the frame is ended, and interrupts that use it must be
+	/// masked.
+	/// </summary>
+	/// <param name="data">
+	/// Array of data bytes to be sent. It must be kept until the frame is
+	/// ended.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	static void beginFrame(const uint8_t * data, uint8_t length) {
+		UCSR0C = UCSR0C_VALUE;
+		UBRR0H = UBRR_VALUE >> 8;
+		UBRR0L = UBRR_VALUE & 0xFF;
+		UCSR0B = (1 << TXEN0);
+		PORTB &= ~(1 << PORTB_PIN);
+		UCSR0A = (1 << TXC0); // Cleared by writing a one.
+		SpiDeviceUsart0Bus::pendingData() = data;
+		SpiDeviceUsart0Bus::pendingLength() = length;
+		SpiDeviceUsart0Bus::isShifting() = (length > 0);
+		continueFrame();
+	}
+
+	/// <summary>
+	/// Write the bytes of the frame begun by beginFrame() that fit into the
+	/// transmit buffer by now, without waiting for it.
+	/// </summary>
+	static void continueFrame(void) {
+		uint8_t & length = SpiDeviceUsart0Bus::pendingLength();
+		while ((length > 0) && (UCSR0A & (1 << UDRE0))) {
+			UDR0 = *SpiDeviceUsart0Bus::pendingData()++;
+			length--;
+		}
+	}
+
+	/// <summary>
+	/// Wait until the last byte of the frame begun by beginFrame() has been
+	/// shifted. Slave select stays asserted.
+	/// </summary>
+	static void flushFrame(void) {
+		while (SpiDeviceUsart0Bus::pendingLength() > 0) {
+			continueFrame();
+		}
+		if (SpiDeviceUsart0Bus::isShifting()) {
+			while (!(UCSR0A & (1 << TXC0))) { }
+			SpiDeviceUsart0Bus::isShifting() = false;
+		}
+	}
+
+	/// <summary>
+	/// End the frame begun by beginFrame(). Waits until its last byte has
+	/// been shifted, then slave select is deasserted.
+	/// </summary>
+	static void endFrame(void) {
+		flushFrame();
+		PORTB |= (1 << PORTB_PIN);
+		UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+	}
+
+	/// <summary>
+	/// Transfer consecutive frames of the same length within a transaction,
+	/// e.g. a conversion of each channel of an ADC.
+	/// </summary>
+	/// <param name="data">
+	/// Array of the frames one after the other. Its content will be
+	/// overwritten by the received bytes.
+	/// </param>
+	/// <param name="length">
+	/// The length of each frame.
+	/// </param>
+	/// <param name="frames">
+	/// The number of frames.
+	/// </param>
+	static void transferFrames(uint8_t* /*[in,out]*/ data,
+			uint8_t length, uint8_t frames) {
+		for (uint8_t i = 0; i < frames; i++) {
+			transferFrame(data + i * length, length);
+		}
+	}
+
+	/// <summary>
+	/// Transfer bytes on the bus.
+	/// </summary>
+	/// <param name="data">
+	/// Array of data bytes to be transfered. The content will be sent in order
+	/// of the array. Its content will be overwritten by the received bytes.
+	/// </param>
+	/// <param name="length">
+	/// The length of the array.
+	/// </param>
+	static void transferBulk(uint8_t* /*[in,out]*/ data, uint8_t length) {
+		beginTransaction();
+		transferFrame(data, length);
+		endTransaction();
+	}
+};
+
+#endif // SPI_DEVICE_USART0_H
@@ -50,6 +50,11 @@
 #include <ConfigurableFirmata.h>
 #include <FirmataExt.h>
 #include <FirmataReporting.h>
+#include <NonBlockingStream.h>
+#include <StreamStatsFirmata.h>
+
+// Uncomment to measure the phases of the scan, see AttackGrid::Phase.
+//#define ATTACK_GRID_PROFILE
 
 #include "AttackGrid.h"
 #include "RgbLedMatrix.h"
@@ -67,31 +72,74 @@ enum {
 	PIN_SIG_LED             = 8,       // Digital pin 8.
 	SIG_LED                 = HIGH,
 	SIG_LED_DURATION        = 1000,    // Time between toggle in ms.
+	FIRMATA_OUTPUT_BYTES    = 32,      // Staged Firmata output per loop.
+	FIRMATA_BACKLOG_BYTES   = 32,      // Replies waiting for the serial port.
+	FIRMATA_RESERVED_BYTES  = 8,       // Serial buffer kept free for replies.
+	FIRMATA_BAUD            = 57600,
+	STREAM_STATS_MESSAGE    = 0x07,    // Sysex query of dropped output.
 };
 
-// Change photodiode min/max values if calibration is needed.
+// Change tile colors if needed. Colors are given as 0xRRGGBB like the CRGB
+// color codes of FastLED. Untouched tiles should not light the red LEDs as
+// they are used to sense the tiles, the photodiodes are calibrated for cyan.
 template<
 	typename RgbLedMatrix,
 	typename RgbLedPhotodiodeArray,
 	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
-	uint8_t FPS
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
 >
-Photodiode AttackGrid<
+const typename AttackGrid<
 	RgbLedMatrix,
 	RgbLedPhotodiodeArray,
 	MAX_ROWS, MAX_COLUMNS,
-	FPS
->::photodiodes[MAX_ROWS][MAX_COLUMNS] = {
-	{ { 0x2F,0x67 },{ 0x34,0x66 },{ 0x41,0x63 },{ 0x4B,0x67 },{ 0x48,0x75 },{ 0x3D,0x66 },{ 0x45,0x64 },{ 0x46,0x69 } }, // Row 0
-	{ { 0x41,0x5B },{ 0x3E,0x68 },{ 0x42,0x67 },{ 0x3B,0x6A },{ 0x37,0x69 },{ 0x47,0x62 },{ 0x39,0x66 },{ 0x36,0x66 } }, // Row 1
-	{ { 0x3D,0x66 },{ 0x3A,0x61 },{ 0x39,0x66 },{ 0x39,0x65 },{ 0x38,0x65 },{ 0x37,0x64 },{ 0x48,0x66 },{ 0x4B,0x69 } }, // Row 2
-	{ { 0x48,0x68 },{ 0x38,0x67 },{ 0x34,0x68 },{ 0x34,0x65 },{ 0x43,0x68 },{ 0x45,0x63 },{ 0x34,0x67 },{ 0x3C,0x64 } }, // Row 3
-	{ { 0x48,0x64 },{ 0x37,0x61 },{ 0x43,0x6A },{ 0x3D,0x64 },{ 0x41,0x62 },{ 0x4D,0x63 },{ 0x56,0x66 },{ 0x39,0x68 } }, // Row 4
-	{ { 0x40,0x5D },{ 0x3B,0x60 },{ 0x39,0x6A },{ 0x41,0x6C },{ 0x42,0x6A },{ 0x3D,0x65 },{ 0x43,0x6A },{ 0x43,0x5A } }, // Row 5
-	{ { 0x32,0x5F },{ 0x42,0x66 },{ 0x52,0x6B },{ 0x35,0x6A },{ 0x48,0x68 },{ 0x39,0x69 },{ 0x3F,0x67 },{ 0x42,0x6B } }, // Row 6
-	{ { 0x32,0x62 },{ 0x46,0x5A },{ 0x3B,0x66 },{ 0x39,0x68 },{ 0x2C,0x62 },{ 0x2B,0x66 },{ 0x4A,0x66 },{ 0x39,0x62 } }, // Row 7
+	FPS,
+	BITS_PER_COLOR
+>::TileStyle AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::tileStyles[] = {
+	{ 0x00FFFF, false }, // NONE:      CRGB::Cyan
+	{ 0x0000FF, false }, // WATER:     CRGB::Blue
+	{ 0xFFFF00, false }, // HIT:       CRGB::Yellow
+	{ 0xFF0000, true  }, // DESTROYED: CRGB::Red (blinking)
+	{ 0x00FFFF, false }, // SELECTED:  CRGB::Cyan
 };
 
+// Change photodiode min/max 10-bit readings if calibration is needed. Each
+// bank holds the photodiodes of one column from row 0 to row 7.
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+PhotodiodeBank<MAX_ROWS> AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::photodiodeBanks[MAX_COLUMNS] = {
+	{ { { 0x0BC,0x19C },{ 0x104,0x16C },{ 0x0F4,0x198 },{ 0x120,0x1A0 },{ 0x120,0x190 },{ 0x100,0x174 },{ 0x0C8,0x17C },{ 0x0C8,0x188 } } }, // Column 0
+	{ { { 0x0D0,0x198 },{ 0x0F8,0x1A0 },{ 0x0E8,0x184 },{ 0x0E0,0x19C },{ 0x0DC,0x184 },{ 0x0EC,0x180 },{ 0x108,0x198 },{ 0x118,0x168 } } }, // Column 1
+	{ { { 0x104,0x18C },{ 0x108,0x19C },{ 0x0E4,0x198 },{ 0x0D0,0x1A0 },{ 0x10C,0x1A8 },{ 0x0E4,0x1A8 },{ 0x148,0x1AC },{ 0x0EC,0x198 } } }, // Column 2
+	{ { { 0x12C,0x19C },{ 0x0EC,0x1A8 },{ 0x0E4,0x194 },{ 0x0D0,0x194 },{ 0x0F4,0x190 },{ 0x104,0x1B0 },{ 0x0D4,0x1A8 },{ 0x0E4,0x1A0 } } }, // Column 3
+	{ { { 0x120,0x1D4 },{ 0x0DC,0x1A4 },{ 0x0E0,0x194 },{ 0x10C,0x1A0 },{ 0x104,0x188 },{ 0x108,0x1A8 },{ 0x120,0x1A0 },{ 0x0B0,0x188 } } }, // Column 4
+	{ { { 0x0F4,0x198 },{ 0x11C,0x188 },{ 0x0DC,0x190 },{ 0x114,0x18C },{ 0x134,0x18C },{ 0x0F4,0x194 },{ 0x0E4,0x1A4 },{ 0x0AC,0x198 } } }, // Column 5
+	{ { { 0x114,0x190 },{ 0x0E4,0x198 },{ 0x120,0x198 },{ 0x0D0,0x19C },{ 0x158,0x198 },{ 0x10C,0x1A8 },{ 0x0FC,0x19C },{ 0x128,0x198 } } }, // Column 6
+	{ { { 0x118,0x1A4 },{ 0x0D8,0x198 },{ 0x12C,0x1A4 },{ 0x0F0,0x190 },{ 0x0E4,0x1A0 },{ 0x10C,0x168 },{ 0x108,0x1AC },{ 0x0E4,0x188 } } }, // Column 7
+};
+
+// Both devices share the SPI, so the columns are written and the photodiodes
+// are read one after the other. With the LED matrix on SpiDeviceUsart0, the
+// AttackGrid shifts the next column while the photodiodes are read. USART0 is
+// the serial port of Firmata on the Uno though, that takes a board with
+// another port for Firmata.
 AttackGrid <
 	RgbLedMatrix<
 	SpiDevicePortB<PIN_SS_LED_MATRIX, F_SCK_LED_MATRIX>
@@ -104,6 +152,11 @@ AttackGrid <
 
 FirmataExt firmataExt;
 FirmataReporting reporting;
+byte firmataOutput[FIRMATA_OUTPUT_BYTES];
+byte firmataBacklog[FIRMATA_BACKLOG_BYTES];
+NonBlockingStream firmataStream(
+	Serial, firmataBacklog, sizeof(firmataBacklog));
+StreamStatsFirmata streamStats(firmataStream, STREAM_STATS_MESSAGE);
 
 void setup() {
 	setupFirmata();
@@ -128,20 +181,34 @@ void loop() {
 		GOTO(SIG_LED_ON);
 	}
 	attackGrid.run();
+	// Hand the replies and tile changes of this loop over at once. If the
+	// serial port is busy, replies wait in the backlog while tile changes
+	// wait in the attack grid, so the loop never blocks on a slow host.
+	Firmata.flush();
 }
 
 void setupFirmata() {
 	Firmata.setFirmwareVersion(FIRMWARE_MAJOR_VERSION, FIRMWARE_MINOR_VERSION);
 	Firmata.disableBlinkVersion();
 	firmataExt.addFeature(attackGrid);
+	firmataExt.addFeature(streamStats);
 	Firmata.attach(SYSTEM_RESET, systemResetCallback);
-	Firmata.begin();
+	firmataStream.setLowPriority(GameGrid::Tile::TILE_CHANGE_MESSAGE);
+	firmataStream.setLowPriority(GameGrid::Tile::TILE_CHANGE_FRAME_MESSAGE);
+	firmataStream.setReserve(FIRMATA_RESERVED_BYTES);
+	Serial.begin(FIRMATA_BAUD);
+	Firmata.begin(firmataStream);
+	Firmata.setOutputBuffer(firmataOutput, sizeof(firmataOutput));
 	systemResetCallback();
 }
 
 void loopFirmata() {
-	while (Firmata.available()) {
-		Firmata.processInput();
+	if (Firmata.available()) {
+		const uint16_t tStartMicros = attackGrid.startTiming();
+		while (Firmata.available()) {
+			Firmata.processInput();
+		}
+		attackGrid.stopTiming(attackGrid.PHASE_FIRMATA_PARSE, tStartMicros);
 	}
 	// TODO: Add code to be processed by firmata.
 }
@@ -150,12 +217,3 @@ void systemResetCallback() {
 	// TODO: Add code to be processed by firmata.
 	firmataExt.reset();
 }
-
-/*
-// Proposed colors:
-const CRGB colors[] = {
-CRGB::Cyan,   // Water.
-CRGB::Yellow, // Hit.
-CRGB::Red     // Sunk (blinking).
-};
-*/
@@ -34,8 +34,8 @@ extern "C" {
  */
 void FirmataClass::sendValueAsTwo7bitBytes(int value)
 {
-  FirmataStream->write(value & B01111111); // LSB
-  FirmataStream->write(value >> 7 & B01111111); // MSB
+  write(value & B01111111); // LSB
+  write(value >> 7 & B01111111); // MSB
 }
 
 /**
@@ -43,7 +43,7 @@ void FirmataClass::sendValueAsTwo7bitBytes(int value)
  */
 void FirmataClass::startSysex(void)
 {
-  FirmataStream->write(START_SYSEX);
+  write(START_SYSEX);
 }
 
 /**
@@ -51,7 +51,7 @@ void FirmataClass::startSysex(void)
  */
 void FirmataClass::endSysex(void)
 {
-  FirmataStream->write(END_SYSEX);
+  write(END_SYSEX);
 }
 
 //******************************************************************************
@@ -66,6 +66,10 @@ FirmataClass::FirmataClass()
 {
   firmwareVersionCount = 0;
   firmwareVersionVector = 0;
+  FirmataSerial = NULL;
+  outputBuffer = NULL;
+  outputSize = 0;
+  outputLength = 0;
   systemReset();
 }
 
@@ -92,6 +96,7 @@ void FirmataClass::begin(long speed)
 {
   Serial.begin(speed);
   FirmataStream = &Serial;
+  FirmataSerial = &Serial;
   blinkVersion();
   printVersion();         // send the protocol version
   printFirmwareVersion(); // send the firmware name and version
@@ -106,6 +111,7 @@ void FirmataClass::begin(long speed)
 void FirmataClass::begin(Stream &s)
 {
   FirmataStream = &s;
+  FirmataSerial = NULL;
   // do not call blinkVersion() here because some hardware such as the
   // Ethernet shield use pin 13
   printVersion();         // send the protocol version
@@ -117,9 +123,9 @@ void FirmataClass::begin(Stream &s)
  */
 void FirmataClass::printVersion(void)
 {
-  FirmataStream->write(REPORT_VERSION);
-  FirmataStream->write(FIRMATA_PROTOCOL_MAJOR_VERSION);
-  FirmataStream->write(FIRMATA_PROTOCOL_MINOR_VERSION);
+  write(REPORT_VERSION);
+  write(FIRMATA_PROTOCOL_MAJOR_VERSION);
+  write(FIRMATA_PROTOCOL_MINOR_VERSION);
 }
 
 /**
@@ -163,9 +169,9 @@ void FirmataClass::printFirmwareVersion(void)
 
   if (firmwareVersionCount) { // make sure that the name has been set before reporting
     startSysex();
-    FirmataStream->write(REPORT_FIRMWARE);
-    FirmataStream->write(firmwareVersionVector[0]); // major version number
-    FirmataStream->write(firmwareVersionVector[1]); // minor version number
+    write(REPORT_FIRMWARE);
+    write(firmwareVersionVector[0]); // major version number
+    write(firmwareVersionVector[1]); // minor version number
     for (i = 2; i < firmwareVersionCount; ++i) {
       sendValueAsTwo7bitBytes(firmwareVersionVector[i]);
     }
@@ -295,11 +301,17 @@ void FirmataClass::parse(byte inputData)
       //stop sysex byte
       parsingSysex = false;
       //fire off handler function
-      processSysexMessage();
-    } else {
+      if (sysexOverflow) {
+        sendString("Sysex message too long");
+      } else {
+        processSysexMessage();
+      }
+    } else if (sysexBytesRead < MAX_DATA_BYTES) {
       //normal data byte - add to buffer
       storedInputData[sysexBytesRead] = inputData;
       sysexBytesRead++;
+    } else {
+      sysexOverflow = true;
     }
   } else if ( (waitForData > 0) && (inputData < 128) ) {
     waitForData--;
@@ -362,6 +374,7 @@ void FirmataClass::parse(byte inputData)
         break;
       case START_SYSEX:
         parsingSysex = true;
+        sysexOverflow = false;
         sysexBytesRead = 0;
         break;
       case SYSTEM_RESET:
@@ -405,7 +418,7 @@ boolean FirmataClass::isResetting(void)
 void FirmataClass::sendAnalog(byte pin, int value)
 {
   // pin can only be 0-15, so chop higher bits
-  FirmataStream->write(ANALOG_MESSAGE | (pin & 0xF));
+  write(ANALOG_MESSAGE | (pin & 0xF));
   sendValueAsTwo7bitBytes(value);
 }
 
@@ -447,9 +460,9 @@ void FirmataClass::sendDigital(byte pin, int value)
  */
 void FirmataClass::sendDigitalPort(byte portNumber, int portData)
 {
-  FirmataStream->write(DIGITAL_MESSAGE | (portNumber & 0xF));
-  FirmataStream->write((byte)portData % 128); // Tx bits 0-6
-  FirmataStream->write(portData >> 7);  // Tx bits 7-13
+  write(DIGITAL_MESSAGE | (portNumber & 0xF));
+  write((byte)portData % 128); // Tx bits 0-6
+  write(portData >> 7);  // Tx bits 7-13
 }
 
 /**
@@ -463,7 +476,7 @@ void FirmataClass::sendSysex(byte command, byte bytec, byte *bytev)
 {
   byte i;
   startSysex();
-  FirmataStream->write(command);
+  write(command);
   for (i = 0; i < bytec; i++) {
     sendValueAsTwo7bitBytes(bytev[i]);
   }
@@ -491,12 +504,92 @@ void FirmataClass::sendString(const char *string)
 
 /**
  * A wrapper for Stream::available().
- * Write a single byte to the output stream.
+ * Write a single byte to the output stream. With an output buffer the byte is
+ * staged until the next call to flush().
  * @param c The byte to be written.
  */
 void FirmataClass::write(byte c)
 {
-  FirmataStream->write(c);
+  if (!outputBuffer) {
+    FirmataStream->write(c);
+    return;
+  }
+  if (outputLength == outputSize) {
+    // more output than the buffer holds, hand it over even if that blocks
+    FirmataStream->write(outputBuffer, outputLength);
+    outputLength = 0;
+  }
+  outputBuffer[outputLength++] = c;
+}
+
+/**
+ * Stage the output in the given buffer instead of writing each byte to the
+ * stream on its own. It must be big enough for the messages sent between two
+ * calls to flush().
+ * @param buffer The buffer, it must stay valid while it is used.
+ * @param size The size of the buffer, or 0 to write each byte unbuffered.
+ */
+void FirmataClass::setOutputBuffer(byte *buffer, byte size)
+{
+  flushBlocking();
+  outputBuffer = size ? buffer : NULL;
+  outputSize = size;
+}
+
+/**
+ * Hand the staged output over to the stream with a single write. If the
+ * transmit buffer of the serial port cannot take all of it, only the whole
+ * messages that fit are written, the rest stays staged. Any other stream gets
+ * all of it, e.g. a NonBlockingStream that keeps or drops messages on its own.
+ * @return false if output is left staged because the stream would block.
+ */
+boolean FirmataClass::flush(void)
+{
+  byte length = outputLength;
+  if (FirmataSerial && length > FirmataSerial->availableForWrite()) {
+    // cut before the start of the first message that does not fit
+    length = FirmataSerial->availableForWrite();
+    while (length > 0 && !isMessageStart(outputBuffer[length])) {
+      length--;
+    }
+  }
+  if (length > 0) {
+    FirmataStream->write(outputBuffer, length);
+    memmove(outputBuffer, outputBuffer + length, outputLength - length);
+    outputLength -= length;
+  }
+  return outputLength == 0;
+}
+
+/**
+ * Hand all staged output over to the stream, even if that blocks.
+ */
+void FirmataClass::flushBlocking(void)
+{
+  if (outputLength > 0) {
+    FirmataStream->write(outputBuffer, outputLength);
+    outputLength = 0;
+  }
+}
+
+/**
+ * @return The number of bytes that can be written besides the staged output,
+ * such that the stream takes them at the next flush() without blocking, e.g.
+ * to hold back a message that a NonBlockingStream would drop.
+ */
+int FirmataClass::availableForWrite(void)
+{
+  const int length = FirmataStream->availableForWrite() - outputLength;
+  return length > 0 ? length : 0;
+}
+
+/**
+ * @return true if the byte starts a message, i.e. all but END_SYSEX of the
+ * command bytes as data is sent with 7 bits.
+ */
+boolean FirmataClass::isMessageStart(byte c)
+{
+  return (c & 0x80) && c != END_SYSEX;
 }
 
 
@@ -667,7 +760,7 @@ void FirmataClass::setPinState(byte pin, int state)
 void FirmataClass::systemReset(void)
 {
   resetting = true;
-  byte i;
+  int i;
 
   waitForData = 0; // this flag says the next serial input will be data
   executeMultiByteCommand = 0; // execute this after getting multi-byte data
@@ -678,6 +771,7 @@ void FirmataClass::systemReset(void)
   }
 
   parsingSysex = false;
+  sysexOverflow = false;
   sysexBytesRead = 0;
 
   if (currentSystemResetCallback)
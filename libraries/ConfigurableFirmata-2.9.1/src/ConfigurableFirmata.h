@@ -46,7 +46,18 @@
 #define FIRMWARE_MINOR_VERSION  9
 #define FIRMWARE_BUGFIX_VERSION 1
 
-#define MAX_DATA_BYTES          64 // max number of data bytes in incoming messages
+// max number of data bytes in incoming messages, i.e. the sysex command and
+// its arguments. Longer sysex messages are dropped and reported. Override it
+// for the whole build only, e.g. with -DMAX_DATA_BYTES=128 in the compiler
+// flags, to receive bigger messages like the bulk upload of a 16x16 grid. It
+// sizes a member of FirmataClass, so every translation unit must see the same
+// value; a #define in a single source file breaks the layout of the class.
+// Features check at compile time that their messages fit.
+#ifndef MAX_DATA_BYTES
+#define MAX_DATA_BYTES          64
+#endif
+static_assert(MAX_DATA_BYTES <= 256,
+  "MAX_DATA_BYTES exceeds the 255 arguments of a sysex callback");
 
 // Arduino 101 also defines SET_PIN_MODE as a macro in scss_registers.h
 #ifdef SET_PIN_MODE
@@ -165,6 +176,10 @@ class FirmataClass
     void sendString(byte command, const char *string);
     void sendSysex(byte command, byte bytec, byte *bytev);
     void write(byte c);
+    void setOutputBuffer(byte *buffer, byte size);
+    boolean flush(void);
+    void flushBlocking(void);
+    int availableForWrite(void);
     /* attach & detach callback functions to messages */
     void attach(byte command, callbackFunction newFunction);
     void attach(byte command, systemResetCallbackFunction newFunction);
@@ -183,11 +198,17 @@ class FirmataClass
 
     /* utility methods */
     void sendValueAsTwo7bitBytes(int value);
+    static boolean isMessageStart(byte c);
     void startSysex(void);
     void endSysex(void);
 
   private:
     Stream *FirmataStream;
+    HardwareSerial *FirmataSerial; // same as FirmataStream if it is a serial port
+    /* output staging */
+    byte *outputBuffer;
+    byte outputSize;
+    byte outputLength;
     /* firmware name and version */
     byte firmwareVersionCount;
     byte *firmwareVersionVector;
@@ -198,6 +219,7 @@ class FirmataClass
     byte storedInputData[MAX_DATA_BYTES]; // multi-byte data
     /* sysex */
     boolean parsingSysex;
+    boolean sysexOverflow; // the message did not fit into storedInputData
     int sysexBytesRead;
     /* pins configuration */
     byte pinConfig[TOTAL_PINS];         // configuration of every pin
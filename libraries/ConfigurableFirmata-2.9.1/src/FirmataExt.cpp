@@ -41,6 +41,9 @@ FirmataExt::FirmataExt()
   Firmata.attach(SET_PIN_MODE, handleSetPinModeCallback);
   Firmata.attach((byte)START_SYSEX, handleSysexCallback);
   numFeatures = 0;
+  for (byte i = 0; i < MAX_SYSEX_COMMANDS / 2; i++) {
+    sysexRoutes[i] = 0;
+  }
 }
 
 void FirmataExt::handleCapability(byte pin)
@@ -59,6 +62,13 @@ boolean FirmataExt::handlePinMode(byte pin, int mode)
 
 boolean FirmataExt::handleSysex(byte command, byte argc, byte* argv)
 {
+  return handleSysexSpan(command, SysexSpan(argv, argc));
+}
+
+boolean FirmataExt::handleSysexSpan(byte command, SysexSpan args)
+{
+  byte argc = args.size();
+  byte *argv = args.data();
   switch (command) {
 
     case PIN_STATE_QUERY:
@@ -92,8 +102,14 @@ boolean FirmataExt::handleSysex(byte command, byte argc, byte* argv)
       Firmata.write(END_SYSEX);
       return true;
     default:
+      {
+        byte route = getSysexRoute(command);
+        if (route != SYSEX_ROUTE_NONE && route != SYSEX_ROUTE_SHARED) {
+          return features[route - 1]->handleSysexSpan(command, args);
+        }
+      }
       for (byte i = 0; i < numFeatures; i++) {
-        if (features[i]->handleSysex(command, argc, argv)) {
+        if (features[i]->handleSysexSpan(command, args)) {
           return true;
         }
       }
@@ -106,6 +122,11 @@ void FirmataExt::addFeature(FirmataFeature &capability)
 {
   if (numFeatures < MAX_FEATURES) {
     features[numFeatures++] = &capability;
+    for (byte command = 0; command < MAX_SYSEX_COMMANDS; command++) {
+      if (capability.handlesSysexCommand(command)) {
+        setSysexRoute(command, getSysexRoute(command) == SYSEX_ROUTE_NONE ? numFeatures : SYSEX_ROUTE_SHARED);
+      }
+    }
   }
 }
 
@@ -115,3 +136,22 @@ void FirmataExt::reset()
     features[i]->reset();
   }
 }
+
+byte FirmataExt::getSysexRoute(byte command)
+{
+  if (command >= MAX_SYSEX_COMMANDS) {
+    return SYSEX_ROUTE_NONE;
+  }
+  byte routes = sysexRoutes[command >> 1];
+  return (command & 1) ? routes >> 4 : routes & 0x0F;
+}
+
+void FirmataExt::setSysexRoute(byte command, byte route)
+{
+  byte *routes = &sysexRoutes[command >> 1];
+  if (command & 1) {
+    *routes = (*routes & 0x0F) | (route << 4);
+  } else {
+    *routes = (*routes & 0xF0) | route;
+  }
+}
@@ -21,6 +21,15 @@
 #include "FirmataFeature.h"
 
 #define MAX_FEATURES TOTAL_PIN_MODES + 1
+#define MAX_SYSEX_COMMANDS 128
+
+// sysex routes are stored as nibbles, see FirmataExt::sysexRoutes
+#define SYSEX_ROUTE_NONE   0x0 // offered to each feature
+#define SYSEX_ROUTE_SHARED 0xF // claimed by more than one feature, offered to each feature
+
+#if MAX_FEATURES >= SYSEX_ROUTE_SHARED
+#error "MAX_FEATURES does not fit into a sysex route"
+#endif
 
 void handleSetPinModeCallback(byte pin, int mode);
 
@@ -33,12 +42,18 @@ class FirmataExt: public FirmataFeature
     void handleCapability(byte pin); //empty method
     boolean handlePinMode(byte pin, int mode);
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handleSysexSpan(byte command, SysexSpan args);
     void addFeature(FirmataFeature &capability);
     void reset();
 
   private:
     FirmataFeature *features[MAX_FEATURES];
     byte numFeatures;
+    // index + 1 of the feature which handles a sysex command, two commands per byte
+    byte sysexRoutes[MAX_SYSEX_COMMANDS / 2];
+
+    byte getSysexRoute(byte command);
+    void setSysexRoute(byte command, byte route);
 };
 
 #endif
@@ -18,6 +18,7 @@
 #define FirmataFeature_h
 
 #include <ConfigurableFirmata.h>
+#include "SysexSpan.h"
 
 class FirmataFeature
 {
@@ -25,6 +26,11 @@ class FirmataFeature
     virtual void handleCapability(byte pin) = 0;
     virtual boolean handlePinMode(byte pin, int mode) = 0;
     virtual boolean handleSysex(byte command, byte argc, byte* argv) = 0;
+    // Same as handleSysex() with the arguments as a view into the input buffer.
+    virtual boolean handleSysexSpan(byte command, SysexSpan args) { return handleSysex(command, args.size(), args.data()); }
+    // Return true for each sysex command this feature handles on its own. These
+    // are routed to the feature directly instead of being offered to each feature.
+    virtual boolean handlesSysexCommand(byte command) { return false; }
     virtual void reset() = 0;
 };
 
@@ -31,6 +31,7 @@ class FirmataReporting: public FirmataFeature
     void handleCapability(byte pin); //empty method
     boolean handlePinMode(byte pin, int mode); //empty method
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == SAMPLING_INTERVAL; }
     boolean elapsed();
     void reset();
   private:
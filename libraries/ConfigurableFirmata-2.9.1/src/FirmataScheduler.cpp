@@ -23,11 +23,27 @@ void delayTaskCallback(long delay)
   FirmataSchedulerInstance->delayTask(delay);
 }
 
+// Compare times of millis() such that the wrap around after 49 days is handled.
+static inline boolean isBefore(long time_ms, long other_ms)
+{
+  return (int32_t)((uint32_t)time_ms - (uint32_t)other_ms) < 0;
+}
+
+// Read a 32 bit value, LSB first, independent of the size of long.
+static long readLong(byte *bytes)
+{
+  uint32_t value = 0;
+  for (byte i = 4; i > 0; i--) {
+    value = (value << 8) | bytes[i - 1];
+  }
+  return (int32_t)value;
+}
+
 FirmataScheduler::FirmataScheduler()
 {
   FirmataSchedulerInstance = this;
-  tasks = NULL;
   running = NULL;
+  reset();
   Firmata.attachDelayTask(delayTaskCallback);
 }
 
@@ -63,9 +79,8 @@ boolean FirmataScheduler::handleSysex(byte command, byte argc, byte* argv)
         case ADD_TO_FIRMATA_TASK:
           {
             if (argc > 2) {
-              int len = num7BitOutbytes(argc - 2);
-              Encoder7Bit.readBinary(len, argv + 2, argv + 2); //decode inplace
-              addToTask(argv[1], len, argv + 2); //addToTask copies data...
+              SysexSpan messages = SysexSpan(argv, argc).subspan(2).decode7Bit(); //decode inplace
+              addToTask(argv[1], messages.size(), messages.data()); //addToTask copies data...
             }
             break;
           }
@@ -74,7 +89,7 @@ boolean FirmataScheduler::handleSysex(byte command, byte argc, byte* argv)
             if (argc == 6) {
               argv++;
               Encoder7Bit.readBinary(4, argv, argv); //decode inplace
-              delayTask(*(long*)((byte*)argv));
+              delayTask(readLong(argv));
             }
             break;
           }
@@ -82,7 +97,7 @@ boolean FirmataScheduler::handleSysex(byte command, byte argc, byte* argv)
           {
             if (argc == 7) { //one byte taskid, 5 bytes to encode 4 bytes of long
               Encoder7Bit.readBinary(4, argv + 2, argv + 2); //decode inplace
-              schedule(argv[1], *(long*)((byte*)argv + 2)); //argv[1] | argv[2]<<8 | argv[3]<<16 | argv[4]<<24
+              schedule(argv[1], readLong(argv + 2)); //argv[2] | argv[3]<<8 | argv[4]<<16 | argv[5]<<24
             }
             break;
           }
@@ -112,39 +127,32 @@ boolean FirmataScheduler::handleSysex(byte command, byte argc, byte* argv)
 void FirmataScheduler::createTask(byte id, int len)
 {
   firmata_task *existing = findTask(id);
-  if (existing) {
+  if (existing || !freeTasks || len < 0 || len > FIRMATA_SCHEDULER_ARENA_SIZE - arenaUsed) {
     reportTask(id, existing, true);
   }
   else {
-    firmata_task *newTask = (firmata_task*)malloc(sizeof(firmata_task) + len);
+    firmata_task *newTask = freeTasks;
+    freeTasks = newTask->nextTask;
     newTask->id = id;
     newTask->time_ms = 0;
     newTask->len = len;
-    newTask->nextTask = tasks;
     newTask->pos = 0;
-    tasks = newTask;
+    newTask->messages = arena + arenaUsed;
+    arenaUsed += len;
+    newTask->nextTask = unscheduled;
+    unscheduled = newTask;
   }
 };
 
 void FirmataScheduler::deleteTask(byte id)
 {
-  firmata_task *current = tasks;
-  firmata_task *previous = NULL;
-  while (current) {
-    if (current->id == id) {
-      if (previous) {
-        previous->nextTask = current->nextTask;
-      }
-      else {
-        tasks = current->nextTask;
-      }
-      free (current);
-      return;
-    }
-    else {
-      previous = current;
-      current = current->nextTask;
-    }
+  firmata_task *task = findTask(id);
+  if (task == running) {
+    running = NULL; //freed by runTasks() once the task returns
+  }
+  else if (task) {
+    unlinkTask(task);
+    freeTask(task);
   }
 };
 
@@ -167,8 +175,15 @@ void FirmataScheduler::schedule(byte id, long delay_ms)
 {
   firmata_task *existing = findTask(id);
   if (existing) {
-    existing->pos = 0;
+    if (delay_ms < 0) { //a task in the past would run again within runTasks()
+      delay_ms = 0;
+    }
     existing->time_ms = millis() + delay_ms;
+    if (existing != running) { //a running task continues after this message
+      existing->pos = 0;
+      unlinkTask(existing);
+      insertTask(existing);
+    }
   }
   else {
     reportTask(id, NULL, true);
@@ -180,7 +195,7 @@ void FirmataScheduler::delayTask(long delay_ms)
   if (running) {
     long now = millis();
     running->time_ms += delay_ms;
-    if (running->time_ms < now) { //if delay time allready passed by schedule to 'now'.
+    if (isBefore(running->time_ms, now)) { //if delay time allready passed by schedule to 'now'.
       running->time_ms = now;
     }
   }
@@ -191,10 +206,11 @@ void FirmataScheduler::queryAllTasks()
   Firmata.write(START_SYSEX);
   Firmata.write(SCHEDULER_DATA);
   Firmata.write(QUERY_ALL_TASKS_REPLY);
-  firmata_task *task = tasks;
-  while (task) {
-    Firmata.write(task->id);
-    task = task->nextTask;
+  firmata_task *lists[] = { tasks, unscheduled };
+  for (byte i = 0; i < 2; i++) {
+    for (firmata_task *task = lists[i]; task; task = task->nextTask) {
+      Firmata.write(task->id);
+    }
   }
   Firmata.write(END_SYSEX);
 };
@@ -216,9 +232,17 @@ void FirmataScheduler::reportTask(byte id, firmata_task *task, boolean error)
   }
   Firmata.write(id);
   if (task) {
+    // time_ms, len and pos as 32, 16 and 16 bit values, LSB first, then the messages
+    uint32_t fields[] = { (uint32_t)task->time_ms, (uint16_t)task->len, (uint16_t)task->pos };
+    byte sizes[] = { 4, 2, 2 };
     Encoder7Bit.startBinaryWrite();
-    for (int i = 3; i < firmata_task_len(task); i++) {
-      Encoder7Bit.writeBinary(((byte *)task)[i]); //don't write first 3 bytes (firmata_task*, byte); makes use of AVR byteorder (LSB first)
+    for (byte i = 0; i < 3; i++) {
+      for (byte j = 0; j < sizes[i]; j++) {
+        Encoder7Bit.writeBinary((byte)(fields[i] >> (8 * j)));
+      }
+    }
+    for (int i = 0; i < task->len; i++) {
+      Encoder7Bit.writeBinary(task->messages[i]);
     }
     Encoder7Bit.endBinaryWrite();
   }
@@ -227,42 +251,36 @@ void FirmataScheduler::reportTask(byte id, firmata_task *task, boolean error)
 
 void FirmataScheduler::runTasks()
 {
-  if (tasks) {
-    long now = millis();
+  // Tasks are ordered by time, so only the due ones are touched. A task that
+  // reschedules or delays itself is due at 'now' at the earliest, which is not
+  // before 'now', so it runs again in the next call only.
+  long now = millis();
+  while (tasks && isBefore(tasks->time_ms, now)) {
     firmata_task *current = tasks;
-    firmata_task *previous = NULL;
-    while (current) {
-      if (current->time_ms > 0 && current->time_ms < now) { // TODO handle overflow
-        if (execute(current)) {
-          previous = current;
-          current = current->nextTask;
-        }
-        else {
-          if (previous) {
-            previous->nextTask = current->nextTask;
-            free(current);
-            current = previous->nextTask;
-          }
-          else {
-            tasks = current->nextTask;
-            free(current);
-            current = tasks;
-          }
-        }
-      }
-      else {
-        current = current->nextTask;
-      }
+    tasks = current->nextTask;
+    if (execute(current)) {
+      insertTask(current);
+    }
+    else if (current->messages) { //not freed by a reset from within the task
+      freeTask(current);
     }
   }
 };
 
 void FirmataScheduler::reset()
 {
-  while (tasks) {
-    firmata_task *nextTask = tasks->nextTask;
-    free(tasks);
-    tasks = nextTask;
+  if (running) {
+    running->messages = NULL; //the running task is dropped as well
+    running = NULL;
+  }
+  tasks = NULL;
+  unscheduled = NULL;
+  freeTasks = NULL;
+  arenaUsed = 0;
+  for (byte i = 0; i < FIRMATA_SCHEDULER_MAX_TASKS; i++) {
+    taskPool[i].messages = NULL;
+    taskPool[i].nextTask = freeTasks;
+    freeTasks = &taskPool[i];
   }
 };
 
@@ -270,14 +288,13 @@ void FirmataScheduler::reset()
 boolean FirmataScheduler::execute(firmata_task *task)
 {
   long start = task->time_ms;
-  int pos = task->pos;
-  int len = task->len;
-  byte *messages = task->messages;
   running = task;
-  while (pos < len) {
-    Firmata.parse(messages[pos++]);
-    if (start != task->time_ms) { // return true if task got rescheduled during run.
-      task->pos = ( pos == len ? 0 : pos ); // last message executed? -> start over next time
+  while (running && task->pos < task->len) {
+    Firmata.parse(task->messages[task->pos++]); //messages may move if another task is deleted
+    if (running && start != task->time_ms) { // return true if task got rescheduled during run.
+      if (task->pos == task->len) { // last message executed? -> start over next time
+        task->pos = 0;
+      }
       running = NULL;
       return true;
     }
@@ -288,13 +305,55 @@ boolean FirmataScheduler::execute(firmata_task *task)
 
 firmata_task *FirmataScheduler::findTask(byte id)
 {
-  firmata_task *currentTask = tasks;
-  while (currentTask) {
-    if (id == currentTask->id) {
-      return currentTask;
-    } else {
-      currentTask = currentTask->nextTask;
+  if (running && running->id == id) {
+    return running;
+  }
+  firmata_task *lists[] = { tasks, unscheduled };
+  for (byte i = 0; i < 2; i++) {
+    for (firmata_task *task = lists[i]; task; task = task->nextTask) {
+      if (id == task->id) {
+        return task;
+      }
     }
-  };
+  }
   return NULL;
 }
+
+void FirmataScheduler::insertTask(firmata_task *task)
+{
+  firmata_task **next = &tasks;
+  while (*next && !isBefore(task->time_ms, (*next)->time_ms)) {
+    next = &(*next)->nextTask;
+  }
+  task->nextTask = *next;
+  *next = task;
+}
+
+void FirmataScheduler::unlinkTask(firmata_task *task)
+{
+  firmata_task **lists[] = { &tasks, &unscheduled };
+  for (byte i = 0; i < 2; i++) {
+    for (firmata_task **next = lists[i]; *next; next = &(*next)->nextTask) {
+      if (*next == task) {
+        *next = task->nextTask;
+        return;
+      }
+    }
+  }
+}
+
+void FirmataScheduler::freeTask(firmata_task *task)
+{
+  // Close the gap in the arena so it never fragments.
+  byte *end = task->messages + task->len;
+  memmove(task->messages, end, (arena + arenaUsed) - end);
+  arenaUsed -= task->len;
+  for (byte i = 0; i < FIRMATA_SCHEDULER_MAX_TASKS; i++) {
+    if (taskPool[i].messages > task->messages) {
+      taskPool[i].messages -= task->len;
+    }
+  }
+  task->messages = NULL;
+  task->nextTask = freeTasks;
+  freeTasks = task;
+}
@@ -30,7 +30,22 @@
 #define QUERY_ALL_TASKS_REPLY   9
 #define QUERY_TASK_REPLY        10
 
-#define firmata_task_len(a)(sizeof(firmata_task)+(a)->len)
+// Number of tasks and total bytes of their messages. The storage is reserved
+// within the scheduler instance, so no heap is used at all. Override them for
+// the whole build only, e.g. with -DFIRMATA_SCHEDULER_ARENA_SIZE=256 in the
+// compiler flags. They size members of FirmataScheduler, so every translation
+// unit must see the same values; a #define in a single source file breaks the
+// layout of the class.
+#ifndef FIRMATA_SCHEDULER_MAX_TASKS
+#define FIRMATA_SCHEDULER_MAX_TASKS  8
+#endif
+#ifndef FIRMATA_SCHEDULER_ARENA_SIZE
+#define FIRMATA_SCHEDULER_ARENA_SIZE 128
+#endif
+static_assert(FIRMATA_SCHEDULER_MAX_TASKS >= 1 && FIRMATA_SCHEDULER_MAX_TASKS <= 128,
+  "FIRMATA_SCHEDULER_MAX_TASKS exceeds the 7 bit task ids");
+static_assert(FIRMATA_SCHEDULER_ARENA_SIZE >= 1 && FIRMATA_SCHEDULER_ARENA_SIZE <= 32767,
+  "FIRMATA_SCHEDULER_ARENA_SIZE exceeds the int offsets into the arena");
 
 void delayTaskCallback(long delay);
 
@@ -41,7 +56,7 @@ struct firmata_task
   long time_ms;
   int len;
   int pos;
-  byte messages[];
+  byte *messages; //points into the arena, NULL if the task is unused
 };
 
 class FirmataScheduler: public FirmataFeature
@@ -51,6 +66,7 @@ class FirmataScheduler: public FirmataFeature
     void handleCapability(byte pin); //empty method
     boolean handlePinMode(byte pin, int mode); //empty method
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == SCHEDULER_DATA; }
     void runTasks();
     void reset();
     void createTask(byte id, int len);
@@ -62,12 +78,20 @@ class FirmataScheduler: public FirmataFeature
     void queryTask(byte id);
 
   private:
-    firmata_task *tasks;
+    firmata_task taskPool[FIRMATA_SCHEDULER_MAX_TASKS];
+    byte arena[FIRMATA_SCHEDULER_ARENA_SIZE];
+    int arenaUsed;
+    firmata_task *freeTasks;
+    firmata_task *tasks; //scheduled tasks ordered by time_ms
+    firmata_task *unscheduled;
     firmata_task *running;
 
     boolean execute(firmata_task *task);
     firmata_task *findTask(byte id);
     void reportTask(byte id, firmata_task *task, boolean error);
+    void insertTask(firmata_task *task);
+    void unlinkTask(firmata_task *task);
+    void freeTask(firmata_task *task);
 };
 
 #endif
@@ -54,6 +54,7 @@ class I2CFirmata: public FirmataFeature
     boolean handlePinMode(byte pin, int mode);
     void handleCapability(byte pin);
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == I2C_REQUEST || command == I2C_CONFIG; }
     void reset();
     void report();
 
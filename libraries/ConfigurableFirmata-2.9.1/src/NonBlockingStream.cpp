@@ -0,0 +1,241 @@
+/*
+  NonBlockingStream.cpp - Firmata library
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include <ConfigurableFirmata.h>
+#include "NonBlockingStream.h"
+
+/**
+ * @param serial The serial port, it must have been started with begin().
+ * @param backlog The buffer for the messages that wait for room in the
+ * transmit buffer of the serial port. It must stay valid while it is used.
+ * @param backlogSize The size of the backlog.
+ */
+NonBlockingStream::NonBlockingStream(HardwareSerial &serial, byte *backlog, byte backlogSize)
+  : serial(serial),
+    backlog(backlog),
+    backlogSize(backlogSize),
+    backlogLength(0),
+    lowPriorityCount(0),
+    reserve(0),
+    isDropping(false),
+    isStalled(false),
+    stallStart(0)
+{
+  resetStats();
+}
+
+/**
+ * Drop the sysex messages of the given command first if the serial port is
+ * busy, e.g. reports that the host can do without.
+ * @param command The sysex command of the messages.
+ */
+void NonBlockingStream::setLowPriority(byte command)
+{
+  if (lowPriorityCount < NON_BLOCKING_STREAM_MAX_LOW_PRIORITY) {
+    lowPriority[lowPriorityCount++] = command;
+  }
+}
+
+/**
+ * Keep room for the replies to the host in the transmit buffer of the serial
+ * port. Low priority messages are only written while they leave this many
+ * bytes free, so that a reply still goes out at once instead of taking up the
+ * backlog while low priority messages saturate the link.
+ * @param size The number of bytes to keep free.
+ */
+void NonBlockingStream::setReserve(byte size)
+{
+  reserve = size;
+}
+
+/**
+ * @return The number of bytes received. Also moves the backlog on, as it is
+ * called once per loop by the sketch.
+ */
+int NonBlockingStream::available()
+{
+  drain();
+  return serial.available();
+}
+
+int NonBlockingStream::read()
+{
+  return serial.read();
+}
+
+int NonBlockingStream::peek()
+{
+  return serial.peek();
+}
+
+/**
+ * Move as much of the backlog to the serial port as fits. Unlike the flush()
+ * of the serial port, this does not wait for the transmission to complete.
+ */
+void NonBlockingStream::flush()
+{
+  drain();
+}
+
+size_t NonBlockingStream::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+/**
+ * Write the messages of the buffer. Bytes before the first command byte
+ * belong to the message of the previous write.
+ * @return Always size, as dropped bytes are accounted for in the statistics.
+ */
+size_t NonBlockingStream::write(const uint8_t *buffer, size_t size)
+{
+  drain();
+  size_t start = 0;
+  while (start < size) {
+    size_t end = start + 1;
+    while (end < size && !FirmataClass::isMessageStart(buffer[end])) {
+      end++;
+    }
+    if (FirmataClass::isMessageStart(buffer[start])) {
+      writeMessage(buffer + start, end - start);
+    } else {
+      writeContinuation(buffer + start, end - start);
+    }
+    start = end;
+  }
+  return size;
+}
+
+/**
+ * @return The number of bytes that can be written without being kept in the
+ * backlog or dropped, also as a low priority message, i.e. without the reserve.
+ */
+int NonBlockingStream::availableForWrite()
+{
+  const int length = serial.availableForWrite() - reserve;
+  return (backlogLength || length < 0) ? 0 : length;
+}
+
+/**
+ * @return The number of bytes that wait to be sent, in the backlog and in the
+ * transmit buffer of the serial port. Its ring buffer holds one byte less than
+ * SERIAL_TX_BUFFER_SIZE.
+ */
+int NonBlockingStream::getQueuedBytes()
+{
+  return backlogLength + (SERIAL_TX_BUFFER_SIZE - 1) - serial.availableForWrite();
+}
+
+/**
+ * @return The time in microseconds the serial port could not take the output.
+ */
+uint32_t NonBlockingStream::getStallMicros()
+{
+  return isStalled ? stallMicros + (micros() - stallStart) : stallMicros;
+}
+
+void NonBlockingStream::resetStats()
+{
+  bytesDropped = 0;
+  messagesDropped = 0;
+  highWaterMark = backlogLength;
+  stallMicros = 0;
+  stallStart = micros();
+}
+
+boolean NonBlockingStream::isLowPriority(const uint8_t *message, size_t size)
+{
+  if (size < 2 || message[0] != START_SYSEX) {
+    return false;
+  }
+  for (byte i = 0; i < lowPriorityCount; i++) {
+    if (message[1] == lowPriority[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void NonBlockingStream::writeMessage(const uint8_t *message, size_t size)
+{
+  isDropping = false;
+  const boolean lowPriority = isLowPriority(message, size);
+  const size_t required = lowPriority ? size + reserve : size;
+  if (backlogLength == 0 && (size_t)serial.availableForWrite() >= required) {
+    serial.write(message, size);
+    return;
+  }
+  stall();
+  if (lowPriority || !enqueue(message, size)) {
+    isDropping = true;
+    messagesDropped++;
+    bytesDropped += size;
+  }
+}
+
+void NonBlockingStream::writeContinuation(const uint8_t *bytes, size_t size)
+{
+  if (isDropping) {
+    bytesDropped += size;
+    return;
+  }
+  if (backlogLength == 0 && (size_t)serial.availableForWrite() >= size) {
+    serial.write(bytes, size);
+    return;
+  }
+  stall();
+  if (!enqueue(bytes, size)) {
+    // the host discards the message that has been cut at the next command byte
+    isDropping = true;
+    messagesDropped++;
+    bytesDropped += size;
+  }
+}
+
+boolean NonBlockingStream::enqueue(const uint8_t *bytes, size_t size)
+{
+  if (size > (size_t)(backlogSize - backlogLength)) {
+    return false;
+  }
+  memcpy(backlog + backlogLength, bytes, size);
+  backlogLength += size;
+  if (backlogLength > highWaterMark) {
+    highWaterMark = backlogLength;
+  }
+  return true;
+}
+
+void NonBlockingStream::drain()
+{
+  if (backlogLength > 0) {
+    int length = serial.availableForWrite();
+    if (length > backlogLength) {
+      length = backlogLength;
+    }
+    if (length > 0) {
+      serial.write(backlog, length);
+      memmove(backlog, backlog + length, backlogLength - length);
+      backlogLength -= length;
+    }
+  }
+  if (isStalled && backlogLength == 0 && serial.availableForWrite() > reserve) {
+    stallMicros += micros() - stallStart;
+    isStalled = false;
+  }
+}
+
+void NonBlockingStream::stall()
+{
+  if (!isStalled) {
+    isStalled = true;
+    stallStart = micros();
+  }
+}
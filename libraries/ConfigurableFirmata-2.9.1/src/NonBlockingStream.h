@@ -0,0 +1,81 @@
+/*
+  NonBlockingStream.h - Firmata library
+  A Stream that wraps a serial port without ever blocking the writer. Pass it
+  to Firmata.begin(Stream &s) instead of the serial port itself.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef NonBlockingStream_h
+#define NonBlockingStream_h
+
+#include <Arduino.h>
+#include <Stream.h>
+
+#define NON_BLOCKING_STREAM_MAX_LOW_PRIORITY 4
+
+/**
+ * Output is written message by message. A message that does not fit into the
+ * transmit buffer of the serial port is kept in the backlog until there is
+ * room, unless it is a sysex message of low priority (see setLowPriority()),
+ * which is dropped instead. The backlog is thereby reserved for the replies to
+ * the host. If even the backlog is full, the message is dropped as well. Part
+ * of the transmit buffer can be kept free of low priority messages too (see
+ * setReserve()).
+ *
+ * Messages are told apart by their command byte, so whole messages should be
+ * written at once, e.g. by staging the output with Firmata.setOutputBuffer().
+ * A writer that must not lose a low priority message can hold it back until
+ * availableForWrite() has room for it.
+ */
+class NonBlockingStream: public Stream
+{
+  public:
+    NonBlockingStream(HardwareSerial &serial, byte *backlog, byte backlogSize);
+    void setLowPriority(byte command);
+    void setReserve(byte size);
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    int availableForWrite();
+    int getQueuedBytes();
+    /* back-pressure statistics */
+    uint32_t getBytesDropped() { return bytesDropped; }
+    uint16_t getMessagesDropped() { return messagesDropped; }
+    byte getHighWaterMark() { return highWaterMark; }
+    uint32_t getStallMicros();
+    void resetStats();
+
+  private:
+    HardwareSerial &serial;
+    byte *backlog;
+    byte backlogSize;
+    byte backlogLength;
+    byte lowPriority[NON_BLOCKING_STREAM_MAX_LOW_PRIORITY];
+    byte lowPriorityCount;
+    byte reserve;
+    boolean isDropping; // the rest of the current message is dropped
+    boolean isStalled;
+    unsigned long stallStart;
+    uint32_t stallMicros;
+    uint32_t bytesDropped;
+    uint16_t messagesDropped;
+    byte highWaterMark;
+    boolean isLowPriority(const uint8_t *message, size_t size);
+    void writeMessage(const uint8_t *message, size_t size);
+    void writeContinuation(const uint8_t *bytes, size_t size);
+    boolean enqueue(const uint8_t *bytes, size_t size);
+    void drain();
+    void stall();
+};
+
+#endif
@@ -53,6 +53,7 @@ class OneWireFirmata: public FirmataFeature
     boolean handlePinMode(byte pin, int mode);
     void handleCapability(byte pin);
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == ONEWIRE_DATA; }
     void reset();
 
   private:
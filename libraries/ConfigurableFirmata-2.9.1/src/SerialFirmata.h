@@ -138,6 +138,7 @@ class SerialFirmata: public FirmataFeature
     boolean handlePinMode(byte pin, int mode);
     void handleCapability(byte pin);
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == SERIAL_MESSAGE; }
     void update();
     void reset();
     void checkSerial();
@@ -36,6 +36,7 @@ class ServoFirmata: public FirmataFeature
     boolean handlePinMode(byte pin, int mode);
     void handleCapability(byte pin);
     boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == SERVO_CONFIG; }
     void reset();
   private:
     Servo *servos[MAX_SERVOS];
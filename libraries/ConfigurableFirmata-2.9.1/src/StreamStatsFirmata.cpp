@@ -0,0 +1,69 @@
+/*
+  StreamStatsFirmata.cpp - Firmata library
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#include <ConfigurableFirmata.h>
+#include "FirmataFeature.h"
+#include "Encoder7Bit.h"
+#include "StreamStatsFirmata.h"
+
+/**
+ * @param stream The stream to report on.
+ * @param command The sysex command of the query and the reply, one of the
+ * user defined commands 0x00 to 0x0F that is not used by the sketch otherwise.
+ */
+StreamStatsFirmata::StreamStatsFirmata(NonBlockingStream &stream, byte command)
+  : stream(stream),
+    command(command)
+{
+}
+
+void StreamStatsFirmata::handleCapability(byte pin)
+{
+
+}
+
+boolean StreamStatsFirmata::handlePinMode(byte pin, int mode)
+{
+  return false;
+}
+
+boolean StreamStatsFirmata::handleSysex(byte command, byte argc, byte* argv)
+{
+  if (command != this->command) {
+    return false;
+  }
+  report();
+  if (argc > 0 && (argv[0] & STREAM_STATS_RESET)) {
+    stream.resetStats();
+  }
+  return true;
+}
+
+void StreamStatsFirmata::reset()
+{
+
+}
+
+void StreamStatsFirmata::report()
+{
+  uint32_t fields[] = { stream.getBytesDropped(), stream.getMessagesDropped(), stream.getStallMicros(), stream.getHighWaterMark() };
+  byte sizes[] = { 4, 2, 4, 1 };
+  Firmata.write(START_SYSEX);
+  Firmata.write(command);
+  Encoder7Bit.startBinaryWrite();
+  for (byte i = 0; i < 4; i++) {
+    for (byte j = 0; j < sizes[i]; j++) {
+      Encoder7Bit.writeBinary((byte)(fields[i] >> (8 * j)));
+    }
+  }
+  Encoder7Bit.endBinaryWrite();
+  Firmata.write(END_SYSEX);
+}
@@ -0,0 +1,47 @@
+/*
+  StreamStatsFirmata.h - Firmata library
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef StreamStatsFirmata_h
+#define StreamStatsFirmata_h
+
+#include <ConfigurableFirmata.h>
+#include "FirmataFeature.h"
+#include "NonBlockingStream.h"
+
+#define STREAM_STATS_RESET 0x01 // flag of the query, reset the statistics once reported
+
+/**
+ * Reports the back-pressure statistics of a NonBlockingStream to the host.
+ *
+ * query: 0xF0 command [flags] 0xF7
+ * reply: 0xF0 command <7-bit encoded statistics> 0xF7
+ *
+ * The statistics are LSB first: bytes dropped (32 bit), messages dropped
+ * (16 bit), time stalled in microseconds (32 bit) and the high-water mark of
+ * the backlog in bytes (8 bit).
+ */
+class StreamStatsFirmata: public FirmataFeature
+{
+  public:
+    StreamStatsFirmata(NonBlockingStream &stream, byte command);
+    void handleCapability(byte pin);
+    boolean handlePinMode(byte pin, int mode);
+    boolean handleSysex(byte command, byte argc, byte* argv);
+    boolean handlesSysexCommand(byte command) { return command == this->command; }
+    void reset();
+
+  private:
+    NonBlockingStream &stream;
+    byte command;
+    void report();
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+  SysexSpan.h - Firmata library
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  See file LICENSE.txt for further informations on licensing terms.
+*/
+
+#ifndef SysexSpan_h
+#define SysexSpan_h
+
+#include <Arduino.h>
+#include "Encoder7Bit.h"
+
+/**
+ * View of the arguments of a sysex message within the input buffer of the
+ * parser. It is valid until the handler returns. The decode methods work in
+ * place, so no copy of the arguments is needed.
+ */
+class SysexSpan
+{
+  public:
+    SysexSpan() : bytes(NULL), length(0) {}
+    SysexSpan(byte *bytes, byte length) : bytes(bytes), length(length) {}
+
+    byte *data() const { return bytes; }
+    byte size() const { return length; }
+    boolean has(byte count) const { return length >= count; }
+    byte operator[](byte index) const { return bytes[index]; }
+
+    /**
+     * @return The arguments from offset on, empty if offset is beyond the end.
+     */
+    SysexSpan subspan(byte offset) const
+    {
+      return (offset < length) ? SysexSpan(bytes + offset, length - offset) : SysexSpan();
+    }
+
+    /**
+     * @return The 14 bit value of the two 7 bit bytes at index, LSB first.
+     */
+    int readPair(byte index) const
+    {
+      return bytes[index] | (bytes[index + 1] << 7);
+    }
+
+    /**
+     * Decode each pair of 7 bit bytes, LSB first, into one byte like for
+     * STRING_DATA.
+     * @return The decoded bytes at the start of this span.
+     */
+    SysexSpan decodePairs()
+    {
+      byte count = length / 2;
+      for (byte i = 0; i < count; i++) {
+        bytes[i] = (byte)readPair(2 * i);
+      }
+      return SysexSpan(bytes, count);
+    }
+
+    /**
+     * Decode bytes packed with Encoder7Bit.
+     * @return The decoded bytes at the start of this span.
+     */
+    SysexSpan decode7Bit()
+    {
+      byte count = num7BitOutbytes(length);
+      Encoder7Bit.readBinary(count, bytes, bytes);
+      return SysexSpan(bytes, count);
+    }
+
+  private:
+    byte *bytes;
+    byte length;
+};
+
+#endif
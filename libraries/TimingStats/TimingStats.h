@@ -46,76 +46,81 @@
  * THE SOFTWARE.
  */
 
-#ifndef PHOTODIODE_H
-#define PHOTODIODE_H
+#ifndef TIMING_STATS_H
+#define TIMING_STATS_H
 
 #include <Arduino.h>
 #include <stdint.h>
 
-class Photodiode {
+/// <summary>
+/// Statistics of the durations of a recurring task in us. Besides min, max
+/// and average it keeps a histogram with buckets of doubling width, such
+/// that outliers can be told apart from a slow average.
+/// </summary>
+class TimingStats {
 
 public:
-	struct OnSignalEdgeListener {
-		virtual ~OnSignalEdgeListener() { }
-		virtual void onRaisingSignalEdge(uint8_t row, uint8_t column) = 0;
-		virtual void onFallingSignalEdge(uint8_t row, uint8_t column) = 0;
+	enum {
+		// Bucket 0 holds durations below 16 us, bucket i those from
+		// 2^(i+3) us on and the last one everything from 1024 us on.
+		HISTOGRAM_BUCKETS = 8,
+		HISTOGRAM_SHIFT   = 4,
 	};
 
 private:
-	uint8_t negativeTreshold;
-	uint8_t positiveTreshold;
-	uint8_t treshold;
-	const float hysteresis;
-	bool logicLevel;
-	OnSignalEdgeListener * onSignalEdgeListener;
+	uint16_t count;
+	uint16_t minMicros;
+	uint16_t maxMicros;
+	uint32_t totalMicros;
+	uint16_t histogram[HISTOGRAM_BUCKETS];
 
 public:
-
-	Photodiode() : Photodiode(0, UINT8_MAX) { }
-
-	Photodiode(uint8_t min, uint8_t max) : Photodiode(min, max, 0.1f) { }
-
-	Photodiode(uint8_t min, uint8_t max, float hysteresisPercentage) :
-		hysteresis(hysteresisPercentage) {
-		setTreshold(min, max);
-		logicLevel = LOW;
-		onSignalEdgeListener = nullptr;
-	}
-
-	void setTreshold(uint8_t min, uint8_t max) {
-		const uint8_t difference = max - min;
-		treshold = (difference / 2) + min;
-		negativeTreshold = treshold - (difference * hysteresis);
-		positiveTreshold = treshold + (difference * hysteresis);
+	TimingStats() {
+		reset();
 	}
 
-	void setOnSignalEdgeListener(OnSignalEdgeListener * onSignalEdgeListener) {
-		this->onSignalEdgeListener = onSignalEdgeListener;
+	void reset() {
+		count = 0;
+		minMicros = UINT16_MAX;
+		maxMicros = 0;
+		totalMicros = 0;
+		for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			histogram[i] = 0;
+		}
 	}
 
 	/// <summary>
-	/// Report the logic level of the photodiode light intensity. I.e. if the
-	/// light level is high or if not.
-	/// The model used represents a crude non inverting comparator with
-	/// hysteresis to compensate signal noise. It also invokes the
-	/// OnSignalEdgeListener.
+	/// Add a duration. The counters saturate instead of wrapping around, so
+	/// stats that have been collected for too long are still consistent.
 	/// </summary>
-	bool getLogicOutputWithHysteresis(
-			uint8_t row, uint8_t column, uint8_t newReading) {
-		if ((logicLevel == LOW) && (newReading > positiveTreshold)) {
-			logicLevel = HIGH;
-			if (onSignalEdgeListener != nullptr) {
-				onSignalEdgeListener->onRaisingSignalEdge(row, column);
-			}
+	void add(uint16_t micros) {
+		if (count == UINT16_MAX) {
+			return;
+		}
+		count++;
+		totalMicros += micros;
+		if (micros < minMicros) {
+			minMicros = micros;
+		}
+		if (micros > maxMicros) {
+			maxMicros = micros;
 		}
-		if ((logicLevel == HIGH) && (newReading < negativeTreshold)) {
-			logicLevel = LOW;
-			if (onSignalEdgeListener != nullptr) {
-				onSignalEdgeListener->onFallingSignalEdge(row, column);
-			}
+		uint8_t bucket = 0;
+		for (uint16_t value = micros >> HISTOGRAM_SHIFT;
+				(value > 0) && (bucket < HISTOGRAM_BUCKETS - 1);
+				value >>= 1) {
+			bucket++;
 		}
-		return logicLevel;
+		histogram[bucket]++;
+	}
+
+	uint16_t getCount() const { return count; }
+	uint16_t getMinMicros() const { return count ? minMicros : 0; }
+	uint16_t getMaxMicros() const { return maxMicros; }
+	uint16_t getAverageMicros() const {
+		return count ? (uint16_t)(totalMicros / count) : 0;
 	}
+	uint16_t getHistogram(uint8_t bucket) const { return histogram[bucket]; }
 };
 
-#endif
+#endif // TIMING_STATS_H
@@ -33,21 +33,206 @@ THE SOFTWARE.
 #include <Arduino.h>
 #include <SPI.h>
 #else
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/spi/spidev.h>
 #endif
 
 #ifndef ARDUINO
-#define SpiDevice_reverseBits(byte) (     \
-        (((byte) & 0x01) ? 0x80 : 0x00) | \
-        (((byte) & 0x02) ? 0x40 : 0x00) | \
-        (((byte) & 0x04) ? 0x20 : 0x00) | \
-        (((byte) & 0x08) ? 0x10 : 0x00) | \
-        (((byte) & 0x10) ? 0x08 : 0x00) | \
-        (((byte) & 0x20) ? 0x04 : 0x00) | \
-        (((byte) & 0x40) ? 0x02 : 0x00) | \
-        (((byte) & 0x80) ? 0x01 : 0x00)   \
-)
+// Bit reversed bytes, expanded two bits at a time from the most significant.
+#define SpiDevice_R2(n) (n), (n) + 2 * 64, (n) + 1 * 64, (n) + 3 * 64
+#define SpiDevice_R4(n) SpiDevice_R2(n), SpiDevice_R2((n) + 2 * 16), \
+	SpiDevice_R2((n) + 1 * 16), SpiDevice_R2((n) + 3 * 16)
+#define SpiDevice_R6(n) SpiDevice_R4(n), SpiDevice_R4((n) + 2 * 4), \
+	SpiDevice_R4((n) + 1 * 4), SpiDevice_R4((n) + 3 * 4)
+
+/// <summary>
+/// Reverse the bits of a byte with a lookup table, so there is no branch per
+/// bit.
+/// </summary>
+inline uint8_t SpiDevice_reverseByte(uint8_t byte) {
+	static constexpr uint8_t reversed[256] = {
+		SpiDevice_R6(0), SpiDevice_R6(2), SpiDevice_R6(1), SpiDevice_R6(3)
+	};
+	return reversed[byte];
+}
+
+/// <summary>
+/// Reverse the bits of each byte, eight bytes at a time by swapping their
+/// neighbouring bits, bit pairs and nibbles in a word. The masks keep the
+/// bits within their byte, so the byte order of the word does not matter.
+/// </summary>
+inline void SpiDevice_reverseBytes(uint8_t*/*[in,out]*/ data, size_t length) {
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		word = ((word >> 1) & 0x5555555555555555ULL) |
+			((word & 0x5555555555555555ULL) << 1);
+		word = ((word >> 2) & 0x3333333333333333ULL) |
+			((word & 0x3333333333333333ULL) << 2);
+		word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) |
+			((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+		memcpy(data + i, &word, sizeof(word));
+	}
+	for (; i < length; i++) {
+		data[i] = SpiDevice_reverseByte(data[i]);
+	}
+}
+
+#undef SpiDevice_R6
+#undef SpiDevice_R4
+#undef SpiDevice_R2
+#endif
+
+#ifndef ARDUINO
+#ifndef SPI_DEVICE_BUS
+#define SPI_DEVICE_BUS 0 // The X of /dev/spidevX.Y, Y is given by PIN_SS.
+#endif
+
+#ifndef SPI_DEVICE_MAX_SEGMENTS
+#define SPI_DEVICE_MAX_SEGMENTS 32 // Frames per SPI_IOC_MESSAGE ioctl.
+#endif
+
+#ifndef SPI_DEVICE_MAX_MESSAGE_BYTES
+#define SPI_DEVICE_MAX_MESSAGE_BYTES 4096 // Bytes per ioctl, bufsiz of spidev.
+#endif
+
+/// <summary>
+/// Access to the spidev devices of the Linux kernel. It can be replaced by a
+/// mock device with use(), e.g. SpiDeviceLoopback to test without hardware.
+/// </summary>
+class SpiDevicePort {
+
+public:
+	virtual ~SpiDevicePort() { }
+
+	virtual int open(uint8_t channel) {
+		char path[32];
+		snprintf(path, sizeof(path), "/dev/spidev%d.%d",
+			SPI_DEVICE_BUS, channel);
+		return ::open(path, O_RDWR);
+	}
+
+	virtual int ioctl(int fd, unsigned long request, void * argument) {
+		return ::ioctl(fd, request, argument);
+	}
+
+	/// <summary>
+	/// Submit the segments with a single SPI_IOC_MESSAGE ioctl.
+	/// </summary>
+	int message(int fd, struct spi_ioc_transfer * segments, size_t count) {
+		return ioctl(fd,
+			_IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(count)),
+			segments);
+	}
+
+	static SpiDevicePort & current() {
+		return *port();
+	}
+
+	/// <summary>
+	/// Route the SpiDevice transfers to the given port, or back to the kernel
+	/// if it is NULL. Devices opened before keep their file descriptor.
+	/// </summary>
+	static void use(SpiDevicePort * newPort) {
+		port() = (newPort != NULL) ? newPort : &kernel();
+	}
+
+private:
+	static SpiDevicePort & kernel() {
+		static SpiDevicePort kernel;
+		return kernel;
+	}
+
+	static SpiDevicePort *& port() {
+		static SpiDevicePort * port = &kernel();
+		return port;
+	}
+};
+
+/// <summary>
+/// Mock device that receives each byte it sends, as if MOSI was wired to
+/// MISO. Override transfer() to emulate a slave instead. It counts the
+/// ioctls and frames, where a frame ends with the deselect of the slave.
+/// Like many controllers, e.g. the one of the Raspberry Pi, it rejects
+/// SPI_LSB_FIRST unless isLsbFirstSupported is set. Like spidev, it rejects
+/// ioctls of more than SPI_DEVICE_MAX_MESSAGE_BYTES.
+/// </summary>
+class SpiDeviceLoopback : public SpiDevicePort {
+
+public:
+	uint32_t messages;
+	uint32_t frames;
+	uint32_t bytes;
+	uint8_t mode;
+	uint8_t bitsPerWord;
+	uint32_t speedHz;
+	bool isLsbFirstSupported;
+
+	SpiDeviceLoopback() :
+		messages(0), frames(0), bytes(0),
+		mode(0), bitsPerWord(0), speedHz(0), isLsbFirstSupported(false) { }
+
+	int open(uint8_t channel) {
+		return channel;
+	}
+
+	int ioctl(int fd, unsigned long request, void * argument) {
+		if (request == SPI_IOC_WR_MODE) {
+			const uint8_t newMode = *static_cast<uint8_t *>(argument);
+			if ((newMode & SPI_LSB_FIRST) && !isLsbFirstSupported) {
+				return -1;
+			}
+			mode = newMode;
+		} else if (request == SPI_IOC_WR_BITS_PER_WORD) {
+			bitsPerWord = *static_cast<uint8_t *>(argument);
+		} else if (request == SPI_IOC_WR_MAX_SPEED_HZ) {
+			speedHz = *static_cast<uint32_t *>(argument);
+		} else if ((_IOC_TYPE(request) == SPI_IOC_MAGIC) &&
+				(_IOC_NR(request) == 0) && (_IOC_DIR(request) == _IOC_WRITE)) {
+			const struct spi_ioc_transfer * segments =
+				static_cast<const struct spi_ioc_transfer *>(argument);
+			const size_t count =
+				_IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+			uint32_t total = 0;
+			for (size_t i = 0; i < count; i++) {
+				total += segments[i].len;
+			}
+			if (total > SPI_DEVICE_MAX_MESSAGE_BYTES) {
+				return -1;
+			}
+			int length = 0;
+			for (size_t i = 0; i < count; i++) {
+				transfer(
+					reinterpret_cast<const uint8_t *>(segments[i].tx_buf),
+					reinterpret_cast<uint8_t *>(segments[i].rx_buf),
+					segments[i].len);
+				length += segments[i].len;
+				// The last segment deselects unless cs_change is set.
+				if ((segments[i].cs_change != 0) == (i + 1 < count)) {
+					frames++;
+				}
+			}
+			messages++;
+			bytes += length;
+			return length;
+		} else {
+			return -1;
+		}
+		return 0;
+	}
+
+protected:
+	virtual void transfer(const uint8_t * tx, uint8_t * rx, uint32_t length) {
+		if ((tx != NULL) && (rx != NULL)) {
+			memmove(rx, tx, length);
+		}
+	}
+};
 #endif
 
 enum SpiBitOrder {
@@ -74,6 +259,13 @@ enum SpiMode {
 #endif
 };
 
+/// <summary>
+/// Bus of all SpiDevice instances. They share the SPI of the Arduino, or the
+/// spidev controller SPI_DEVICE_BUS on Linux, so their transfers follow one
+/// another.
+/// </summary>
+struct SpiDeviceBus {};
+
 template<
 	uint8_t PIN_SS,
 	uint32_t F_SCK = 4000000/*Hz*/,
@@ -81,15 +273,55 @@ template<
 	SpiMode MODE = SpiMode0>
 class SpiDevice {
 
+#ifndef ARDUINO
+	static int & fd() {
+		static int fd = -1;
+		return fd;
+	}
+
+	/// <summary>
+	/// True if the bits are reversed in software, i.e. LSB-first transfers
+	/// with a controller that only shifts MSB first.
+	/// </summary>
+	static bool & isReversedInSoftware() {
+		static bool isReversedInSoftware = false;
+		return isReversedInSoftware;
+	}
+
+	static void reverseBits(uint8_t*/*[in,out]*/ data, size_t length) {
+		if ((BIT_ORDER == SpiBitOrderLsbFirst) && isReversedInSoftware()) {
+			SpiDevice_reverseBytes(data, length);
+		}
+	}
+#endif
+
 public:
+	typedef SpiDeviceBus Bus;
+
 	static void master(void) {
 #ifdef ARDUINO
 		digitalWrite(PIN_SS, HIGH);
 		pinMode(PIN_SS, OUTPUT);
 		SPI.begin();
 #else
-		wiringPiSetup();
-		wiringPiSPISetupMode(PIN_SS, F_SCK, MODE);
+		SpiDevicePort & port = SpiDevicePort::current();
+		fd() = port.open(PIN_SS);
+		uint8_t mode = MODE;
+		uint8_t bitsPerWord = 8;
+		uint32_t speedHz = F_SCK;
+		// Let the controller shift LSB first if it can, else the bits are
+		// reversed before and after each transfer.
+		isReversedInSoftware() = false;
+		if (BIT_ORDER == SpiBitOrderLsbFirst) {
+			uint8_t lsbFirstMode = mode | SPI_LSB_FIRST;
+			isReversedInSoftware() =
+				port.ioctl(fd(), SPI_IOC_WR_MODE, &lsbFirstMode) < 0;
+		}
+		if ((BIT_ORDER != SpiBitOrderLsbFirst) || isReversedInSoftware()) {
+			port.ioctl(fd(), SPI_IOC_WR_MODE, &mode);
+		}
+		port.ioctl(fd(), SPI_IOC_WR_BITS_PER_WORD, &bitsPerWord);
+		port.ioctl(fd(), SPI_IOC_WR_MAX_SPEED_HZ, &speedHz);
 #endif
 	}
 
@@ -102,15 +334,9 @@ public:
 		SPI.endTransaction();
 		return in;
 #else
-		if (BIT_ORDER == SpiBitOrderLsbFirst) {
-			data = SpiDevice_reverseBits(data);
-		}
-		if (wiringPiSPIDataRW(PIN_SS, &data, sizeof(uint8_t)) < 0) {
+		if (!transferFrames(&data, sizeof(data), 1)) {
 			return 0;
 		}
-		if (BIT_ORDER == SpiBitOrderLsbFirst) {
-			return SpiDevice_reverseBits(data);
-		}
 		return data;
 #endif
 	}
@@ -125,22 +351,23 @@ public:
 		SPI.endTransaction();
 		return in;
 #else
-		if (BIT_ORDER == SpiBitOrderLsbFirst) {
-			command = SpiDevice_reverseBits(command);
-			value   = SpiDevice_reverseBits(value);
-		}
 		uint8_t buffer[2] = { command, value };
-		if (wiringPiSPIDataRW(PIN_SS, buffer, sizeof(buffer)) < 0) {
+		if (!transferFrames(buffer, sizeof(buffer), 1)) {
 			return 0;
 		}
-		if (BIT_ORDER == SpiBitOrderLsbFirst) {
-			return SpiDevice_reverseBits(buffer[1]);
-		}
 		return buffer[1];
 #endif
 	}
 
-	static void transferBulk(uint8_t*/*[in,out]*/ data, size_t length) {
+	/// <summary>
+	/// Transfer the bytes as one frame in a transaction of its own. On Linux
+	/// a frame is a single ioctl, so it fails beyond
+	/// SPI_DEVICE_MAX_MESSAGE_BYTES instead of deselecting the slave midway.
+	/// </summary>
+	/// <returns>
+	/// False if the transfer failed.
+	/// </returns>
+	static bool transferBulk(uint8_t*/*[in,out]*/ data, size_t length) {
 #ifdef ARDUINO
 		SPI.beginTransaction(SPISettings(F_SCK, BIT_ORDER, MODE));
 		digitalWrite(PIN_SS, LOW);
@@ -149,18 +376,104 @@ public:
 		}
 		digitalWrite(PIN_SS, HIGH);
 		SPI.endTransaction();
+		return true;
 #else
-		if (BIT_ORDER == SpiBitOrderLsbFirst) {
-                        for (size_t i = 0; i < length; i++) {
-				data[i] = SpiDevice_reverseBits(data[i]);
+		return transferFrames(data, length, 1);
+#endif
+	}
+
+	/// <summary>
+	/// Begin a transaction, frames within it are transfered with the same
+	/// settings. It is not needed on Linux, as each ioctl brings its own.
+	/// </summary>
+	static void beginTransaction(void) {
+#ifdef ARDUINO
+		SPI.beginTransaction(SPISettings(F_SCK, BIT_ORDER, MODE));
+#endif
+	}
+
+	/// <summary>
+	/// End a transaction begun by beginTransaction().
+	/// </summary>
+	static void endTransaction(void) {
+#ifdef ARDUINO
+		SPI.endTransaction();
+#endif
+	}
+
+	/// <summary>
+	/// Transfer one frame, i.e. bytes framed by slave select, within a
+	/// transaction. Like transferBulk(), it fails on Linux beyond
+	/// SPI_DEVICE_MAX_MESSAGE_BYTES.
+	/// </summary>
+	/// <returns>
+	/// False if the transfer failed.
+	/// </returns>
+	static bool transferFrame(uint8_t*/*[in,out]*/ data, size_t length) {
+#ifdef ARDUINO
+		digitalWrite(PIN_SS, LOW);
+		for (size_t i = 0; i < length; i++) {
+			data[i] = SPI.transfer(data[i]);
+		}
+		digitalWrite(PIN_SS, HIGH);
+		return true;
+#else
+		return transferFrames(data, length, 1);
+#endif
+	}
+
+	/// <summary>
+	/// Transfer consecutive frames of the same length within a transaction,
+	/// e.g. a conversion of each channel of an ADC. On Linux they are
+	/// submitted as segments of a single ioctl, up to SPI_DEVICE_MAX_SEGMENTS
+	/// and SPI_DEVICE_MAX_MESSAGE_BYTES at once, where cs_change deselects
+	/// the slave between them. A frame is never split, a single one beyond
+	/// SPI_DEVICE_MAX_MESSAGE_BYTES fails.
+	/// </summary>
+	/// <returns>
+	/// False if the transfer failed.
+	/// </returns>
+	static bool transferFrames(uint8_t*/*[in,out]*/ data,
+			size_t length, size_t frames) {
+#ifdef ARDUINO
+		for (size_t frame = 0; frame < frames; frame++) {
+			transferFrame(data + frame * length, length);
+		}
+		return true;
+#else
+		if (length > SPI_DEVICE_MAX_MESSAGE_BYTES) {
+			return false;
+		}
+		reverseBits(data, length * frames);
+		struct spi_ioc_transfer segments[SPI_DEVICE_MAX_SEGMENTS];
+		const size_t maxCount = (length > 0)
+			? SPI_DEVICE_MAX_MESSAGE_BYTES / length : SPI_DEVICE_MAX_SEGMENTS;
+		bool isTransfered = true;
+		for (size_t frame = 0; isTransfered && (frame < frames); ) {
+			size_t count = frames - frame;
+			if (count > SPI_DEVICE_MAX_SEGMENTS) {
+				count = SPI_DEVICE_MAX_SEGMENTS;
 			}
-                }
-		wiringPiSPIDataRW(PIN_SS, data, length);
-                if (BIT_ORDER == SpiBitOrderLsbFirst) {
-                        for (size_t i = 0; i < length; i++) {
-                                data[i] = SpiDevice_reverseBits(data[i]);
-                        }
-                }
+			if (count > maxCount) {
+				count = maxCount;
+			}
+			memset(segments, 0, count * sizeof(segments[0]));
+			for (size_t i = 0; i < count; i++) {
+				uint8_t * segment = data + (frame + i) * length;
+				segments[i].tx_buf = reinterpret_cast<uintptr_t>(segment);
+				segments[i].rx_buf = reinterpret_cast<uintptr_t>(segment);
+				segments[i].len = length;
+				segments[i].speed_hz = F_SCK;
+				segments[i].bits_per_word = 8;
+				// Set on the last segment it would keep the slave selected.
+				segments[i].cs_change = (i + 1 < count);
+			}
+			isTransfered =
+				SpiDevicePort::current().message(fd(), segments, count) >= 0;
+			frame += count;
+		}
+		reverseBits(data, length * frames);
+		return isTransfered;
 #endif
 	}
 };
@@ -0,0 +1,265 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <TimerOne.h>
+
+SimRegister PORTB(sim::REGISTER_PORTB);
+SimRegister PORTC(sim::REGISTER_PORTC);
+SimRegister PORTD(sim::REGISTER_PORTD);
+SimRegister DDRB(sim::REGISTER_DDRB);
+SimRegister DDRC(sim::REGISTER_DDRC);
+SimRegister DDRD(sim::REGISTER_DDRD);
+SimRegister PINB(sim::REGISTER_PINB);
+SimRegister PINC(sim::REGISTER_PINC);
+SimRegister PIND(sim::REGISTER_PIND);
+// The Arduino core enables interrupts before setup() is called.
+SimRegister SREG(sim::REGISTER_SREG, (1 << SREG_I));
+SimRegister SPCR(sim::REGISTER_SPCR);
+SimRegister SPSR(sim::REGISTER_SPSR);
+SimRegister SPDR(sim::REGISTER_SPDR);
+SimRegister UCSR0A(sim::REGISTER_UCSR0A, (1 << UDRE0));
+SimRegister UCSR0B(sim::REGISTER_UCSR0B);
+SimRegister UCSR0C(sim::REGISTER_UCSR0C, (1 << 2) | (1 << 1)); // 8N1
+SimRegister UBRR0L(sim::REGISTER_UBRR0L);
+SimRegister UBRR0H(sim::REGISTER_UBRR0H);
+SimRegister UDR0(sim::REGISTER_UDR0);
+
+HardwareSerial Serial;
+SPIClass SPI;
+TimerOne Timer1;
+
+// Digital and analog pins.
+
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static uint8_t pinValues[NUM_DIGITAL_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if (pin < NUM_DIGITAL_PINS) {
+		pinModes[pin] = mode;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	if (pin < NUM_DIGITAL_PINS) {
+		pinValues[pin] = value ? HIGH : LOW;
+	}
+}
+
+int digitalRead(uint8_t pin) {
+	return (pin < NUM_DIGITAL_PINS) ? pinValues[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+	return 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+	digitalWrite(pin, value > 0 ? HIGH : LOW);
+}
+
+// Time.
+
+// Both wrap around at 32 bits like on the AVR.
+
+unsigned long millis() {
+	return static_cast<uint32_t>(sim::nanos() / 1000000ULL);
+}
+
+unsigned long micros() {
+	return static_cast<uint32_t>(sim::nanos() / 1000ULL);
+}
+
+void delay(unsigned long ms) {
+	const uint64_t until = sim::nanos() + ms * 1000000ULL;
+	while (sim::nanos() < until) {
+		sim::idle();
+	}
+}
+
+void delayMicroseconds(unsigned int us) {
+	sim::consume(us * 1000UL);
+}
+
+void yield() { }
+
+// USART.
+
+HardwareSerial::HardwareSerial() : baud(0),
+	rxHead(0), rxTail(0), rxCount(0), txHead(0), txTail(0), txCount(0) { }
+
+void HardwareSerial::begin(unsigned long baud) {
+	this->baud = baud;
+	rxHead = rxTail = rxCount = 0;
+	txHead = txTail = txCount = 0;
+}
+
+void HardwareSerial::end() {
+	flush();
+	baud = 0;
+}
+
+int HardwareSerial::available() {
+	return rxCount;
+}
+
+int HardwareSerial::peek() {
+	return (rxCount > 0) ? rxBuffer[rxTail] : -1;
+}
+
+int HardwareSerial::read() {
+	if (rxCount == 0) {
+		return -1;
+	}
+	const uint8_t data = rxBuffer[rxTail];
+	rxTail = (rxTail + 1) % SERIAL_RX_BUFFER_SIZE;
+	rxCount--;
+	return data;
+}
+
+int HardwareSerial::availableForWrite() {
+	return SERIAL_TX_BUFFER_SIZE - 1 - txCount;
+}
+
+void HardwareSerial::flush() {
+	while (txCount > 0) {
+		sim::idle();
+	}
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+	// Like the AVR core, wait for the interrupt to free up the buffer.
+	while (txCount >= SERIAL_TX_BUFFER_SIZE - 1) {
+		sim::idle();
+	}
+	if (txCount == 0) {
+		sim::onSerialTransmitStart();
+	}
+	txBuffer[txHead] = data;
+	txHead = (txHead + 1) % SERIAL_TX_BUFFER_SIZE;
+	txCount++;
+	return 1;
+}
+
+bool HardwareSerial::receive(uint8_t data) {
+	if (rxCount >= SERIAL_RX_BUFFER_SIZE - 1) {
+		return false;
+	}
+	rxBuffer[rxHead] = data;
+	rxHead = (rxHead + 1) % SERIAL_RX_BUFFER_SIZE;
+	rxCount++;
+	return true;
+}
+
+int HardwareSerial::transmit() {
+	if (txCount == 0) {
+		return -1;
+	}
+	const uint8_t data = txBuffer[txTail];
+	txTail = (txTail + 1) % SERIAL_TX_BUFFER_SIZE;
+	txCount--;
+	return data;
+}
+
+// SPI.
+
+uint8_t SPIClass::interruptMode = 0;
+uint8_t SPIClass::interruptSave = 0;
+uint8_t SPIClass::clockDivider = 4;
+
+void SPIClass::begin() {
+	DDRB |= (1 << PB2) | (1 << PB3) | (1 << PB5);
+	SPCR |= (1 << MSTR) | (1 << SPE);
+}
+
+void SPIClass::end() { }
+
+void SPIClass::usingInterrupt(uint8_t interruptNumber) {
+	interruptMode = 1;
+}
+
+void SPIClass::notUsingInterrupt(uint8_t interruptNumber) {
+	interruptMode = 0;
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+	if (interruptMode) {
+		interruptSave = SREG;
+		cli();
+	}
+	// Fastest clock of the AVR that does not exceed the requested one.
+	clockDivider = 2;
+	while ((clockDivider < 128) && (F_CPU / clockDivider > settings.clock)) {
+		clockDivider <<= 1;
+	}
+	sim::consume(sim::SPI_TRANSACTION_NANOS);
+}
+
+void SPIClass::endTransaction() {
+	if (interruptMode) {
+		SREG = interruptSave;
+	}
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+	return sim::spiTransfer(data, clockDivider);
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+	const uint8_t msb = transfer(data >> 8);
+	const uint8_t lsb = transfer(data & 0xFF);
+	return (msb << 8) | lsb;
+}
+
+void SPIClass::transfer(void * buffer, size_t count) {
+	uint8_t * data = static_cast<uint8_t *>(buffer);
+	for (size_t i = 0; i < count; i++) {
+		data[i] = transfer(data[i]);
+	}
+}
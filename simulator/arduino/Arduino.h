@@ -0,0 +1,281 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Minimal Arduino Uno core for Linux hosts. Time, registers and peripherals
+ * are provided by the simulator in sim/, such that the sketches can be
+ * compiled and tested without the hardware.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <avr/pgmspace.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+
+#define B01111111 0x7F
+
+// Arduino Uno pinout.
+#define NUM_DIGITAL_PINS  20
+#define NUM_ANALOG_INPUTS 6
+#define digitalPinHasPWM(p) \
+	((p) == 3 || (p) == 5 || (p) == 6 || (p) == 9 || (p) == 10 || (p) == 11)
+
+static const uint8_t SS   = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK  = 13;
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define SREG_I 7
+
+// SPI control and status register bits.
+#define SPR0  0
+#define SPR1  1
+#define CPHA  2
+#define CPOL  3
+#define MSTR  4
+#define DORD  5
+#define SPE   6
+#define SPIE  7
+#define SPI2X 0
+#define WCOL  6
+#define SPIF  7
+
+// USART0 register bits, as far as used in master SPI mode.
+#define RXC0    7
+#define TXC0    6
+#define UDRE0   5
+#define RXEN0   4
+#define TXEN0   3
+#define UMSEL01 7
+#define UMSEL00 6
+#define UDORD0  2
+#define UCPHA0  1
+#define UCPOL0  0
+
+namespace sim {
+
+	enum Register {
+		REGISTER_PORTB, REGISTER_PORTC, REGISTER_PORTD,
+		REGISTER_DDRB,  REGISTER_DDRC,  REGISTER_DDRD,
+		REGISTER_PINB,  REGISTER_PINC,  REGISTER_PIND,
+		REGISTER_SREG,
+		REGISTER_SPCR,  REGISTER_SPSR,  REGISTER_SPDR,
+		REGISTER_UCSR0A, REGISTER_UCSR0B, REGISTER_UCSR0C,
+		REGISTER_UBRR0L, REGISTER_UBRR0H, REGISTER_UDR0,
+		MAX_REGISTERS
+	};
+
+	/// <summary>
+	/// Invoked by the registers on each write, i.e. to emulate slave select
+	/// edges or pending interrupts.
+	/// </summary>
+	void onRegisterWrite(Register reg, uint8_t oldValue, uint8_t newValue);
+
+	/// <summary>
+	/// Invoked by the registers on each read, i.e. to emulate receive buffers.
+	/// </summary>
+	/// <returns>
+	/// The value that is read.
+	/// </returns>
+	uint8_t onRegisterRead(Register reg, uint8_t value);
+
+	/// <summary>
+	/// Let the simulated CPU spend time, e.g. for a SPI byte transfer.
+	/// </summary>
+	void consume(uint32_t nanos);
+
+	/// <summary>
+	/// Let the simulated CPU wait for the next peripheral event.
+	/// </summary>
+	void idle();
+
+	uint64_t nanos();
+
+	enum CoreTimingModel {
+		// Time of SPI.beginTransaction() and SPI.endTransaction().
+		SPI_TRANSACTION_NANOS    = 1500,
+		// Cycles spent per SPI byte besides shifting.
+		SPI_BYTE_OVERHEAD_CYCLES = 9,
+		// Cycles spent per SPI byte besides shifting if SPDR is written
+		// directly and the next byte is loaded while shifting.
+		SPDR_BYTE_OVERHEAD_CYCLES = 4,
+		// Cycles of a transaction that writes SPCR and SPSR directly,
+		// including masking interrupts. Spent on the write of SPCR, or on
+		// the write of UCSR0C for USART0 in master SPI mode.
+		SPCR_TRANSACTION_CYCLES  = 16,
+		// Cycles spent per byte of USART0 in master SPI mode besides
+		// shifting. None, as the transmit buffer is filled while shifting.
+		UDR0_BYTE_OVERHEAD_CYCLES = 0,
+		// Cycles of one iteration of a loop that polls UCSR0A. USART0
+		// shifts in the background, so time passes while it is polled.
+		UCSR0A_POLL_CYCLES = 4,
+	};
+
+	/// <summary>
+	/// Shift a byte through the SPI slave that is currently selected. Takes
+	/// the time of the SCK given by the clock divider of F_CPU.
+	/// </summary>
+	uint8_t spiTransfer(uint8_t data, uint8_t clockDivider,
+		uint8_t overheadCycles = SPI_BYTE_OVERHEAD_CYCLES);
+
+	/// <summary>
+	/// The USART has been idle and a byte has been written to it.
+	/// </summary>
+	void onSerialTransmitStart();
+
+}
+
+/// <summary>
+/// 8-bit I/O register. Each write is forwarded to the simulator.
+/// </summary>
+class SimRegister {
+
+	volatile uint8_t value;
+	const sim::Register reg;
+
+public:
+	explicit SimRegister(sim::Register reg, uint8_t value = 0) :
+		value(value), reg(reg) { }
+
+	operator uint8_t() const { return sim::onRegisterRead(reg, value); }
+
+	/// <summary>
+	/// Change the value from the side of the peripheral, i.e. without the
+	/// effects of a write by the firmware.
+	/// </summary>
+	void set(uint8_t newValue) { value = newValue; }
+
+	/// <summary>
+	/// Get the value from the side of the peripheral, i.e. without the
+	/// effects of a read by the firmware.
+	/// </summary>
+	uint8_t get() const { return value; }
+
+	SimRegister & operator=(uint8_t newValue) {
+		const uint8_t oldValue = value;
+		value = newValue;
+		sim::onRegisterWrite(reg, oldValue, newValue);
+		return *this;
+	}
+	SimRegister & operator=(const SimRegister & other) {
+		return *this = static_cast<uint8_t>(other);
+	}
+	SimRegister & operator|=(uint8_t bits) { return *this = value | bits; }
+	SimRegister & operator&=(uint8_t bits) { return *this = value & bits; }
+	SimRegister & operator^=(uint8_t bits) { return *this = value ^ bits; }
+};
+
+extern SimRegister PORTB, PORTC, PORTD;
+extern SimRegister DDRB, DDRC, DDRD;
+extern SimRegister PINB, PINC, PIND;
+extern SimRegister SREG;
+extern SimRegister SPCR, SPSR, SPDR;
+extern SimRegister UCSR0A, UCSR0B, UCSR0C, UBRR0L, UBRR0H, UDR0;
+
+inline void cli() { SREG &= static_cast<uint8_t>(~(1 << SREG_I)); }
+inline void sei() { SREG |= (1 << SREG_I); }
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+#include "HardwareSerial.h"
+
+#endif // Arduino_h
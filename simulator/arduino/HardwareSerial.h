@@ -0,0 +1,109 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <stdint.h>
+
+#include "Stream.h"
+
+// Ring buffer sizes of the AVR core, which sketches may refer to as well.
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+
+/// <summary>
+/// USART with the 64 byte ring buffers of the AVR core, which hold one byte
+/// less than their size. The simulator shifts the bytes in and out at the
+/// configured baud rate, so a full transmit buffer blocks write() just like
+/// on the hardware.
+/// </summary>
+class HardwareSerial : public Stream {
+
+	unsigned long baud;
+	uint8_t rxBuffer[SERIAL_RX_BUFFER_SIZE];
+	uint8_t rxHead;
+	uint8_t rxTail;
+	uint8_t rxCount;
+	uint8_t txBuffer[SERIAL_TX_BUFFER_SIZE];
+	uint8_t txHead;
+	uint8_t txTail;
+	uint8_t txCount;
+
+public:
+	HardwareSerial();
+
+	void begin(unsigned long baud);
+	void end();
+	operator bool() { return true; }
+
+	int available();
+	int peek();
+	int read();
+	int availableForWrite();
+	void flush();
+	size_t write(uint8_t data);
+	using Print::write;
+
+	// Simulator side of the USART.
+
+	unsigned long getBaud() const { return baud; }
+	/// <summary>
+	/// A byte has been received on RX. Returns false on a buffer overrun.
+	/// </summary>
+	bool receive(uint8_t data);
+	/// <summary>
+	/// A byte has been shifted out on TX. Returns -1 if there was none.
+	/// </summary>
+	int transmit();
+	bool isTransmitting() const { return txCount > 0; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // HardwareSerial_h
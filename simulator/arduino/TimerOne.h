@@ -0,0 +1,108 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TimerOne_h_
+#define TimerOne_h_
+
+#include <Arduino.h>
+
+/// <summary>
+/// Timer1 overflow interrupt. The simulator invokes the attached function
+/// once per period while interrupts are enabled. Changing the period from
+/// within the interrupt applies to the next overflow like on the ATmega328.
+/// </summary>
+class TimerOne {
+
+public:
+	unsigned long periodMicros;
+	uint64_t lastOverflowNanos;
+	bool running;
+	void (*isrCallback)();
+
+	TimerOne() : periodMicros(1000000), lastOverflowNanos(0),
+		running(false), isrCallback(nullptr) { }
+
+	void initialize(unsigned long microseconds = 1000000) {
+		setPeriod(microseconds);
+		restart();
+	}
+
+	void setPeriod(unsigned long microseconds) {
+		periodMicros = microseconds;
+	}
+
+	void start() { restart(); }
+	void stop() { running = false; }
+	void resume() { running = true; }
+
+	void restart() {
+		lastOverflowNanos = sim::nanos();
+		running = true;
+	}
+
+	void attachInterrupt(void (*isr)()) {
+		isrCallback = isr;
+	}
+
+	void attachInterrupt(void (*isr)(), unsigned long microseconds) {
+		setPeriod(microseconds);
+		attachInterrupt(isr);
+	}
+
+	void detachInterrupt() {
+		isrCallback = nullptr;
+	}
+
+	uint64_t nextOverflowNanos() const {
+		return lastOverflowNanos + 1000ULL * periodMicros;
+	}
+};
+
+extern TimerOne Timer1;
+
+#endif // TimerOne_h_
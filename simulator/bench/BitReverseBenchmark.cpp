@@ -0,0 +1,140 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Throughput of LSB-first bulk transfers with the Linux backend of SpiDevice,
+ * whose bits are reversed before and after the transfer unless the controller
+ * shifts LSB first itself. The branch per bit reversal that SpiDevice used
+ * before is compared to the lookup table and to the swap within words, then
+ * the whole transfer through a loopback with the reversal to a baseline whose
+ * controller shifts LSB first, so no bits are reversed at all.
+ */
+
+#include <stdio.h>
+#include <chrono>
+
+#include <SpiDevice.h>
+
+namespace {
+
+	enum {
+		BULK_BYTES = 4096,
+		TRANSFERS  = 20000,
+		F_SCK      = 2000000,
+	};
+
+	typedef SpiDevice<0, F_SCK, SpiBitOrderLsbFirst> Device;
+
+	uint8_t data[BULK_BYTES];
+
+	// The former reversal of SpiDevice, with a branch per bit.
+	#define SpiDevice_reverseBits(byte) (     \
+	        (((byte) & 0x01) ? 0x80 : 0x00) | \
+	        (((byte) & 0x02) ? 0x40 : 0x00) | \
+	        (((byte) & 0x04) ? 0x20 : 0x00) | \
+	        (((byte) & 0x08) ? 0x10 : 0x00) | \
+	        (((byte) & 0x10) ? 0x08 : 0x00) | \
+	        (((byte) & 0x20) ? 0x04 : 0x00) | \
+	        (((byte) & 0x40) ? 0x02 : 0x00) | \
+	        (((byte) & 0x80) ? 0x01 : 0x00)   \
+	)
+
+	void reverseByMacro(uint8_t * data, size_t length) {
+		for (size_t i = 0; i < length; i++) {
+			data[i] = SpiDevice_reverseBits(data[i]);
+		}
+	}
+
+	void reverseByTable(uint8_t * data, size_t length) {
+		for (size_t i = 0; i < length; i++) {
+			data[i] = SpiDevice_reverseByte(data[i]);
+		}
+	}
+
+	void transferBulk(uint8_t * data, size_t length) {
+		Device::transferBulk(data, length);
+	}
+
+	// Called through a volatile pointer, so that the two reversals of a
+	// transfer are not folded into none.
+	void run(const char * name, void (* volatile reverse)(uint8_t *, size_t),
+			int passes) {
+		for (size_t i = 0; i < sizeof(data); i++) {
+			data[i] = i;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < TRANSFERS; i++) {
+			for (int pass = 0; pass < passes; pass++) {
+				reverse(data, sizeof(data));
+			}
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		const double seconds =
+			std::chrono::duration<double>(stop - start).count();
+		printf("%-10s %7.2f us per transfer, %8.1f MB/s\n", name,
+			seconds * 1e6 / TRANSFERS,
+			static_cast<double>(BULK_BYTES) * TRANSFERS / seconds / 1e6);
+	}
+}
+
+int main() {
+	printf("Bulk transfers of %d bytes:\n", BULK_BYTES);
+	run("macro", reverseByMacro, 2);
+	run("table", reverseByTable, 2);
+	run("words", SpiDevice_reverseBytes, 2);
+	SpiDeviceLoopback loopback;
+	SpiDevicePort::use(&loopback);
+	Device::master();
+	run("reversed", transferBulk, 1);
+	// Baseline without any reversal, the controller shifts LSB first.
+	loopback.isLsbFirstSupported = true;
+	Device::master();
+	run("baseline", transferBulk, 1);
+	SpiDevicePort::use(NULL);
+	return 0;
+}
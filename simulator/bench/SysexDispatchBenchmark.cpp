@@ -0,0 +1,125 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Cost of routing a sysex message through FirmataExt. The features either
+ * claim their command, so it is routed by the dispatch table, or they do not,
+ * so the message is offered to each feature in turn like before.
+ */
+
+#include <stdio.h>
+#include <chrono>
+
+#include <ConfigurableFirmata.h>
+#include <FirmataExt.h>
+
+namespace {
+
+	enum {
+		FEATURES    = MAX_FEATURES,
+		MESSAGES    = 1000000,
+		// Commands of the features, the last one is the benchmarked one.
+		COMMAND_BASE = 0x01,
+	};
+
+	uint32_t offered = 0;
+
+	class Feature : public FirmataFeature {
+		byte command;
+		bool claims;
+
+	public:
+		Feature() : command(0), claims(false) { }
+
+		void init(byte command, bool claims) {
+			this->command = command;
+			this->claims = claims;
+		}
+
+		void handleCapability(byte pin) { }
+		boolean handlePinMode(byte pin, int mode) { return false; }
+		void reset() { }
+
+		boolean handleSysex(byte command, byte argc, byte* argv) {
+			offered++;
+			return command == this->command;
+		}
+
+		boolean handlesSysexCommand(byte command) {
+			return claims && (command == this->command);
+		}
+	};
+
+	void run(const char * name, bool claims) {
+		static Feature features[2][FEATURES];
+		Feature * set = features[claims ? 1 : 0];
+		FirmataExt firmataExt;
+		for (byte i = 0; i < FEATURES; i++) {
+			set[i].init(COMMAND_BASE + i, claims);
+			firmataExt.addFeature(set[i]);
+		}
+		byte argv[] = { 0x00, 0x00, 0x00 };
+		offered = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < MESSAGES; i++) {
+			firmataExt.handleSysex(COMMAND_BASE + FEATURES - 1, sizeof(argv), argv);
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		const double nanos = std::chrono::duration<double, std::nano>(
+			stop - start).count() / MESSAGES;
+		printf("%-8s %5.1f features offered, %6.2f ns per message\n", name,
+			static_cast<double>(offered) / MESSAGES, nanos);
+	}
+}
+
+int main() {
+	printf("Dispatch to the last of %d features:\n", FEATURES);
+	run("polled", false);
+	run("routed", true);
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "FirmataHost.h"
+#include "Simulator.h"
+
+namespace sim {
+
+	FirmataHost::FirmataHost() :
+		parsed(0), inSysex(false), status(0), expected(0) { }
+
+	void FirmataHost::send(const std::vector<uint8_t> & bytes) {
+		hostWrite(bytes);
+	}
+
+	void FirmataHost::sendSysex(
+			uint8_t command, const std::vector<uint8_t> & data) {
+		std::vector<uint8_t> bytes;
+		bytes.push_back(START_SYSEX);
+		bytes.push_back(command);
+		bytes.insert(bytes.end(), data.begin(), data.end());
+		bytes.push_back(END_SYSEX);
+		send(bytes);
+	}
+
+	std::vector<FirmataHost::Message> FirmataHost::receive() {
+		std::vector<Message> messages;
+		const std::vector<uint8_t> & bytes = hostReceived();
+		for (; parsed < bytes.size(); parsed++) {
+			const uint8_t data = bytes[parsed];
+			if (data == START_SYSEX) {
+				inSysex = true;
+				partial.clear();
+			} else if (inSysex) {
+				if (data == END_SYSEX) {
+					inSysex = false;
+					if (!partial.empty()) {
+						const uint8_t command = partial.front();
+						partial.erase(partial.begin());
+						messages.push_back({ true, command, partial });
+					}
+				} else {
+					partial.push_back(data);
+				}
+			} else if (data & 0x80) {
+				status = data;
+				partial.clear();
+				// Channel messages and the protocol version have 2 data bytes,
+				// the reporting messages have one.
+				switch (status & 0xF0) {
+				case 0xC0: case 0xD0: expected = 1; break;
+				default: expected = 2; break;
+				}
+			} else if (status != 0) {
+				partial.push_back(data);
+				if (partial.size() == expected) {
+					messages.push_back({ false, status, partial });
+					status = 0;
+				}
+			}
+		}
+		return messages;
+	}
+
+	std::vector<FirmataHost::Message> FirmataHost::receiveSysex(
+			uint8_t command) {
+		std::vector<Message> matching;
+		for (const Message & message : receive()) {
+			if (message.sysex && (message.command == command)) {
+				matching.push_back(message);
+			}
+		}
+		return matching;
+	}
+
+	std::vector<uint8_t> FirmataHost::decode7Bit(
+			const uint8_t * data, size_t length, size_t outBytes) {
+		std::vector<uint8_t> decoded(outBytes, 0);
+		for (size_t i = 0; i < outBytes; i++) {
+			const size_t bit = i * 8;
+			const size_t pos = bit / 7;
+			const uint8_t shift = bit % 7;
+			const uint8_t low = (pos < length) ? data[pos] : 0;
+			const uint8_t high = (pos + 1 < length) ? data[pos + 1] : 0;
+			decoded[i] = static_cast<uint8_t>(
+				(low >> shift) | (high << (7 - shift)));
+		}
+		return decoded;
+	}
+
+	std::vector<uint8_t> FirmataHost::encode7Bit(
+			const std::vector<uint8_t> & bytes) {
+		std::vector<uint8_t> encoded((bytes.size() * 8 + 6) / 7, 0);
+		for (size_t i = 0; i < bytes.size(); i++) {
+			for (uint8_t b = 0; b < 8; b++) {
+				if (bytes[i] & (1 << b)) {
+					const size_t bit = i * 8 + b;
+					encoded[bit / 7] |= static_cast<uint8_t>(1 << (bit % 7));
+				}
+			}
+		}
+		return encoded;
+	}
+}
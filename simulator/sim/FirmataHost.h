@@ -0,0 +1,113 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FIRMATA_HOST_H
+#define FIRMATA_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace sim {
+
+	/// <summary>
+	/// Firmata client of the host computer connected to the simulated USART.
+	/// </summary>
+	class FirmataHost {
+
+	public:
+		enum {
+			START_SYSEX = 0xF0,
+			END_SYSEX   = 0xF7,
+		};
+
+		struct Message {
+			bool sysex;
+			// The sysex command or else the status byte.
+			uint8_t command;
+			std::vector<uint8_t> data;
+		};
+
+	private:
+		size_t parsed;
+		std::vector<uint8_t> partial;
+		bool inSysex;
+		uint8_t status;
+		uint8_t expected;
+
+	public:
+		FirmataHost();
+
+		void send(const std::vector<uint8_t> & bytes);
+		void sendSysex(uint8_t command, const std::vector<uint8_t> & data);
+
+		/// <summary>
+		/// Messages completely received since the last call.
+		/// </summary>
+		std::vector<Message> receive();
+
+		/// <summary>
+		/// Messages of the given sysex command received since the last call.
+		/// Messages of other commands are dropped.
+		/// </summary>
+		std::vector<Message> receiveSysex(uint8_t command);
+
+		/// <summary>
+		/// Decode bytes packed with Encoder7Bit.
+		/// </summary>
+		static std::vector<uint8_t> decode7Bit(
+			const uint8_t * data, size_t length, size_t outBytes);
+
+		/// <summary>
+		/// Encode bytes like Encoder7Bit.
+		/// </summary>
+		static std::vector<uint8_t> encode7Bit(const std::vector<uint8_t> & bytes);
+	};
+}
+
+#endif // FIRMATA_HOST_H
@@ -0,0 +1,101 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Mcp3008.h"
+
+namespace sim {
+
+	enum Mcp3008Clocks {
+		// Clocks after the start bit.
+		SINGLE_NOT_DIFF_CLOCK = 1,
+		CHANNEL_MSB_CLOCK     = 2,
+		CHANNEL_LSB_CLOCK     = 4,
+		NULL_BIT_CLOCK        = 6,
+		RESULT_MSB_CLOCK      = 7,
+		RESULT_LSB_CLOCK      = 16,
+	};
+
+	Mcp3008::Mcp3008() : clock(0), startClock(-1), channel(0), value(0) {
+		source = [](uint8_t) { return static_cast<uint16_t>(0); };
+	}
+
+	void Mcp3008::select() {
+		clock = 0;
+		startClock = -1;
+		channel = 0;
+		value = 0;
+	}
+
+	uint8_t Mcp3008::transfer(uint8_t mosi) {
+		uint8_t miso = 0x00;
+		for (int8_t i = 7; i >= 0; i--, clock++) {
+			const uint8_t bit = (mosi >> i) & 0x01;
+			uint8_t out = 0;
+			if (startClock < 0) {
+				if (bit) {
+					startClock = clock;
+				}
+			} else {
+				const int k = clock - startClock;
+				if ((k >= CHANNEL_MSB_CLOCK) && (k <= CHANNEL_LSB_CLOCK)) {
+					channel = (channel << 1) | bit;
+				}
+				if (k == CHANNEL_LSB_CLOCK) {
+					// The input is sampled after the channel has been given.
+					value = source(channel) & READING_MAX;
+					history.push_back({ nanos(), channel, value });
+				}
+				if ((k >= RESULT_MSB_CLOCK) && (k <= RESULT_LSB_CLOCK)) {
+					out = (value >> (RESULT_LSB_CLOCK - k)) & 0x01;
+				}
+			}
+			miso = (miso << 1) | out;
+		}
+		return miso;
+	}
+}
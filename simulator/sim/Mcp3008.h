@@ -0,0 +1,102 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MCP3008_H
+#define MCP3008_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "Simulator.h"
+
+namespace sim {
+
+	/// <summary>
+	/// MCP3008 8-channel 10-bit ADC. It follows the bit level protocol of the
+	/// datasheet, so both the 2-byte and the byte aligned 3-byte framing work.
+	/// The sampled value of each conversion is taken from a source function.
+	/// </summary>
+	class Mcp3008 : public SpiSlave {
+
+	public:
+		enum {
+			CHANNELS    = 8,
+			READING_MAX = 0x3FF,
+		};
+
+		typedef std::function<uint16_t(uint8_t channel)> Source;
+
+		struct Conversion {
+			uint64_t nanos;
+			uint8_t channel;
+			uint16_t value;
+		};
+
+	private:
+		Source source;
+		int clock;
+		int startClock;
+		uint8_t channel;
+		uint16_t value;
+		std::vector<Conversion> history;
+
+	public:
+		Mcp3008();
+
+		void setSource(Source source) { this->source = source; }
+
+		void select();
+		uint8_t transfer(uint8_t mosi);
+
+		const std::vector<Conversion> & conversions() const { return history; }
+		void clearConversions() { history.clear(); }
+	};
+}
+
+#endif // MCP3008_H
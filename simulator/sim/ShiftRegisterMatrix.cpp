@@ -0,0 +1,138 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "ShiftRegisterMatrix.h"
+
+namespace sim {
+
+	ShiftRegisterMatrix::ShiftRegisterMatrix() : chain(0) {
+		memset(&output, 0, sizeof(output));
+		clearIntegration();
+	}
+
+	void ShiftRegisterMatrix::integrate(uint64_t until) {
+		const uint64_t duration = until - output.nanos;
+		for (uint8_t column = 0; column < COLUMNS; column++) {
+			if (!(output.columns & (1 << column))) {
+				continue;
+			}
+			for (uint8_t row = 0; row < ROWS; row++) {
+				for (uint8_t color = 0; color < MAX_COLORS; color++) {
+					if (output.rows[color] & (1 << row)) {
+						onNanos[row][column][color] += duration;
+					}
+				}
+			}
+		}
+		output.nanos = until;
+	}
+
+	void ShiftRegisterMatrix::deselect() {
+		integrate(nanos());
+		output.columns = static_cast<uint8_t>(chain >> 24);
+		output.rows[BLUE] = static_cast<uint8_t>(~(chain >> 16));
+		output.rows[GREEN] = static_cast<uint8_t>(~(chain >> 8));
+		output.rows[RED] = static_cast<uint8_t>(~chain);
+		history.push_back(output);
+	}
+
+	uint8_t ShiftRegisterMatrix::transfer(uint8_t mosi) {
+		const uint8_t shiftedOut = static_cast<uint8_t>(chain >> 24);
+		chain = (chain << 8) | mosi;
+		return shiftedOut;
+	}
+
+	int ShiftRegisterMatrix::activeColumn() const {
+		for (uint8_t column = 0; column < COLUMNS; column++) {
+			if (output.columns & (1 << column)) {
+				return column;
+			}
+		}
+		return -1;
+	}
+
+	double ShiftRegisterMatrix::dutyCycle(
+			uint8_t row, uint8_t column, Color color) {
+		integrate(nanos());
+		const uint64_t elapsed = nanos() - integrationStartNanos;
+		if (elapsed == 0) {
+			return 0.0;
+		}
+		return static_cast<double>(onNanos[row][column][color]) / elapsed;
+	}
+
+	void ShiftRegisterMatrix::clearIntegration() {
+		memset(onNanos, 0, sizeof(onNanos));
+		output.nanos = nanos();
+		integrationStartNanos = nanos();
+	}
+
+	std::string ShiftRegisterMatrix::render() {
+		// Index by the bits of red, green and blue.
+		static const char symbols[] = ".RGYBMCW";
+		std::string text;
+		for (uint8_t row = 0; row < ROWS; row++) {
+			for (uint8_t column = 0; column < COLUMNS; column++) {
+				uint8_t index = 0;
+				for (uint8_t color = 0; color < MAX_COLORS; color++) {
+					// A column is lit at most 1/8 of the time.
+					const double threshold = 0.25 / COLUMNS;
+					if (dutyCycle(row, column, static_cast<Color>(color))
+							> threshold) {
+						index |= (1 << color);
+					}
+				}
+				text += symbols[index];
+			}
+			text += '\n';
+		}
+		return text;
+	}
+}
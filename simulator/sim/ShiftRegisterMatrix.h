@@ -0,0 +1,127 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SHIFT_REGISTER_MATRIX_H
+#define SHIFT_REGISTER_MATRIX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Simulator.h"
+
+namespace sim {
+
+	/// <summary>
+	/// RGB LED matrix driven by a chain of 74HC595 shift registers as written
+	/// by RgbLedMatrix::writeColumn(), i.e. the column select byte followed by
+	/// the inverted blue, green and red row bytes. The outputs are latched on
+	/// the rising edge of slave select. The on-time of each LED is integrated
+	/// such that the shown colors can be rendered.
+	/// </summary>
+	class ShiftRegisterMatrix : public SpiSlave {
+
+	public:
+		enum {
+			ROWS      = 8,
+			COLUMNS   = 8,
+			REGISTERS = 4,
+		};
+
+		enum Color {
+			RED,
+			GREEN,
+			BLUE,
+			MAX_COLORS
+		};
+
+		struct Latch {
+			uint64_t nanos;
+			uint8_t columns;
+			uint8_t rows[MAX_COLORS];
+		};
+
+	private:
+		uint32_t chain;
+		Latch output;
+		std::vector<Latch> history;
+		uint64_t integrationStartNanos;
+		uint64_t onNanos[ROWS][COLUMNS][MAX_COLORS];
+
+		void integrate(uint64_t until);
+
+	public:
+		ShiftRegisterMatrix();
+
+		void deselect();
+		uint8_t transfer(uint8_t mosi);
+
+		/// <summary>
+		/// Column which is currently lit or -1 if there is none.
+		/// </summary>
+		int activeColumn() const;
+
+		const std::vector<Latch> & latches() const { return history; }
+		void clearLatches() { history.clear(); }
+
+		/// <summary>
+		/// Fraction of time an LED has been lit since clearIntegration().
+		/// </summary>
+		double dutyCycle(uint8_t row, uint8_t column, Color color);
+		void clearIntegration();
+
+		/// <summary>
+		/// Render the integrated colors with one character per LED, i.e. the
+		/// first letter of red, green, blue, yellow, cyan, magenta or white.
+		/// Dark LEDs are shown as dots.
+		/// </summary>
+		std::string render();
+	};
+}
+
+#endif // SHIFT_REGISTER_MATRIX_H
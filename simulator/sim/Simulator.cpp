@@ -0,0 +1,416 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <deque>
+#include <vector>
+
+#include "Simulator.h"
+
+#include <Arduino.h>
+#include <TimerOne.h>
+
+namespace sim {
+
+	enum {
+		MAX_SPI_SLAVES = 8,
+	};
+
+	struct SpiSlaveSelect {
+		SpiSlave * slave;
+		uint8_t pin;
+		SpiBus bus;
+		bool selected;
+	};
+
+	/// <summary>
+	/// Byte of USART0 in master SPI mode, in the shift register or in the
+	/// transmit buffer waiting for it.
+	/// </summary>
+	struct UsartShift {
+		uint64_t doneNanos;
+		uint8_t miso;
+	};
+
+	static uint64_t now = 0;
+	static SpiSlaveSelect spiSlaves[MAX_SPI_SLAVES];
+	static uint8_t spiSlaveCount = 0;
+	static bool inInterrupt = false;
+	static std::deque<uint8_t> usartReceived;
+	static std::deque<UsartShift> usartShifting;
+	static uint64_t serialTxNextNanos = 0;
+	static uint64_t serialRxNextNanos = 0;
+	static std::deque<uint8_t> hostTx;
+	static std::vector<uint8_t> hostRx;
+	static InterruptStats isrStats;
+	static LoopStats loopStatistics;
+	static SerialStats serialStatistics;
+
+	static uint64_t cyclesToNanos(uint64_t cycles) {
+		return (cycles * 1000000000ULL + F_CPU - 1) / F_CPU;
+	}
+
+	static uint64_t serialByteNanos() {
+		return (SERIAL_BITS_PER_BYTE * 1000000000ULL) / Serial.getBaud();
+	}
+
+	static bool isTimerPending() {
+		return Timer1.running && (Timer1.isrCallback != nullptr) &&
+			(Timer1.nextOverflowNanos() <= now);
+	}
+
+	static void dispatchTimerInterrupt() {
+		if (inInterrupt) {
+			return;
+		}
+		while (isTimerPending() && (SREG & (1 << SREG_I))) {
+			Timer1.lastOverflowNanos = Timer1.nextOverflowNanos();
+			inInterrupt = true;
+			SREG &= static_cast<uint8_t>(~(1 << SREG_I));
+			const uint64_t start = now;
+			consume(ISR_OVERHEAD_NANOS);
+			Timer1.isrCallback();
+			const uint64_t duration = now - start;
+			isrStats.count++;
+			isrStats.busyNanos += duration;
+			if (duration > isrStats.maxNanos) {
+				isrStats.maxNanos = static_cast<uint32_t>(duration);
+			}
+			if (now > Timer1.nextOverflowNanos()) {
+				isrStats.overruns++;
+			}
+			SREG |= (1 << SREG_I);
+			inInterrupt = false;
+		}
+	}
+
+	static void processSerial() {
+		if (Serial.getBaud() == 0) {
+			return;
+		}
+		const uint64_t byteNanos = serialByteNanos();
+		while (Serial.isTransmitting() && (serialTxNextNanos <= now)) {
+			hostRx.push_back(static_cast<uint8_t>(Serial.transmit()));
+			serialStatistics.txBytes++;
+			serialTxNextNanos += byteNanos;
+		}
+		while (!hostTx.empty() && (serialRxNextNanos <= now)) {
+			if (!Serial.receive(hostTx.front())) {
+				serialStatistics.rxOverruns++;
+			}
+			hostTx.pop_front();
+			serialRxNextNanos += byteNanos;
+		}
+	}
+
+	/// <summary>
+	/// Complete the bytes that USART0 has shifted in master SPI mode until
+	/// now. Like the hardware, at most two received bytes are buffered.
+	/// </summary>
+	static void processUsart() {
+		while (!usartShifting.empty() &&
+				(usartShifting.front().doneNanos <= now)) {
+			if ((UCSR0B.get() & (1 << RXEN0)) && (usartReceived.size() < 2)) {
+				usartReceived.push_back(usartShifting.front().miso);
+				UCSR0A.set(UCSR0A.get() | (1 << RXC0));
+			}
+			usartShifting.pop_front();
+			UCSR0A.set(UCSR0A.get() | (1 << UDRE0));
+			if (usartShifting.empty()) {
+				UCSR0A.set(UCSR0A.get() | (1 << TXC0));
+			}
+		}
+	}
+
+	static void processEvents() {
+		processSerial();
+		processUsart();
+		dispatchTimerInterrupt();
+	}
+
+	uint64_t nanos() {
+		return now;
+	}
+
+	void consume(uint32_t nanos) {
+		// Split the time at the next timer overflow such that the interrupt
+		// preempts the firmware on time instead of after a long SPI transfer
+		// or loop iteration.
+		uint64_t remaining = nanos;
+		do {
+			uint64_t step = remaining;
+			if (!inInterrupt && (SREG & (1 << SREG_I)) &&
+					Timer1.running && (Timer1.isrCallback != nullptr)) {
+				const uint64_t next = Timer1.nextOverflowNanos();
+				if ((next > now) && ((next - now) < step)) {
+					step = next - now;
+				}
+			}
+			now += step;
+			remaining -= step;
+			processEvents();
+		} while (remaining > 0);
+	}
+
+	void idle() {
+		uint64_t next = now + 1000;
+		if (Serial.isTransmitting() && (serialTxNextNanos < next)) {
+			next = serialTxNextNanos;
+		}
+		if (!hostTx.empty() && (serialRxNextNanos < next)) {
+			next = serialRxNextNanos;
+		}
+		if (Timer1.running && (Timer1.isrCallback != nullptr) &&
+				(Timer1.nextOverflowNanos() < next)) {
+			next = Timer1.nextOverflowNanos();
+		}
+		const bool isStalled = (Serial.availableForWrite() == 0);
+		const uint64_t start = now;
+		consume(static_cast<uint32_t>((next > now) ? (next - now) : 0));
+		if (isStalled) {
+			serialStatistics.txStallNanos += now - start;
+		}
+	}
+
+	/// <summary>
+	/// Clock divider of F_CPU given by SPCR and SPSR.
+	/// </summary>
+	static uint8_t spiClockDivider() {
+		static const uint8_t dividers[] = { 4, 16, 64, 128 };
+		const uint8_t divider = dividers[SPCR & ((1 << SPR1) | (1 << SPR0))];
+		return (SPSR & (1 << SPI2X)) ? (divider >> 1) : divider;
+	}
+
+	/// <summary>
+	/// Clock divider of F_CPU given by UBRR0 in master SPI mode.
+	/// </summary>
+	static uint32_t usartClockDivider() {
+		return 2UL * (((UBRR0H & 0x0F) << 8 | UBRR0L) + 1);
+	}
+
+	static bool isUsartMasterSpi() {
+		const uint8_t mode = (1 << UMSEL01) | (1 << UMSEL00);
+		return ((UCSR0C & mode) == mode) && (UCSR0B & (1 << TXEN0));
+	}
+
+	/// <summary>
+	/// Shift a byte through the slave of the bus that is currently selected.
+	/// </summary>
+	static uint8_t busTransfer(SpiBus bus, uint8_t data) {
+		uint8_t miso = 0xFF; // Pulled up if no slave is selected.
+		for (uint8_t i = 0; i < spiSlaveCount; i++) {
+			if (spiSlaves[i].selected && (spiSlaves[i].bus == bus)) {
+				miso = spiSlaves[i].slave->transfer(data);
+			}
+		}
+		return miso;
+	}
+
+	void onRegisterWrite(Register reg, uint8_t oldValue, uint8_t newValue) {
+		if ((reg == REGISTER_PORTB) || (reg == REGISTER_DDRB)) {
+			for (uint8_t i = 0; i < spiSlaveCount; i++) {
+				SpiSlaveSelect & s = spiSlaves[i];
+				const bool selected = (DDRB & (1 << s.pin)) &&
+					!(PORTB & (1 << s.pin));
+				if (selected && !s.selected) {
+					s.selected = true;
+					s.slave->select();
+				} else if (!selected && s.selected) {
+					s.selected = false;
+					s.slave->deselect();
+				}
+			}
+		} else if (reg == REGISTER_SREG) {
+			if ((newValue & (1 << SREG_I)) && !(oldValue & (1 << SREG_I))) {
+				dispatchTimerInterrupt();
+			}
+		} else if (reg == REGISTER_SPCR) {
+			consume(static_cast<uint32_t>(cyclesToNanos(
+				SPCR_TRANSACTION_CYCLES)));
+		} else if (reg == REGISTER_SPSR) {
+			// Only SPI2X can be written, the flags are kept.
+			SPSR.set((oldValue & ~(1 << SPI2X)) | (newValue & (1 << SPI2X)));
+		} else if (reg == REGISTER_SPDR) {
+			// The byte is shifted at once, so SPIF is set when the firmware
+			// starts polling it.
+			SPSR.set(SPSR & ~(1 << SPIF));
+			SPDR.set(spiTransfer(newValue, spiClockDivider(),
+				SPDR_BYTE_OVERHEAD_CYCLES));
+			SPSR.set(SPSR | (1 << SPIF));
+		} else if (reg == REGISTER_UCSR0A) {
+			// TXC0 is cleared by writing a one, the other flags are kept.
+			UCSR0A.set(oldValue & ~(newValue & (1 << TXC0)));
+		} else if (reg == REGISTER_UCSR0B) {
+			// Disabling the receiver flushes its buffer.
+			if (!(newValue & (1 << RXEN0))) {
+				usartReceived.clear();
+				UCSR0A.set(UCSR0A.get() & ~(1 << RXC0));
+			}
+		} else if (reg == REGISTER_UCSR0C) {
+			if (isUsartMasterSpi()) {
+				consume(static_cast<uint32_t>(cyclesToNanos(
+					SPCR_TRANSACTION_CYCLES)));
+			}
+		} else if ((reg == REGISTER_UDR0) && isUsartMasterSpi()) {
+			// The byte is shifted in the background once the previous one is
+			// done, unlike on the SPI the firmware goes on meanwhile. The
+			// transmit buffer holds the byte that waits for the shift
+			// register, the firmware polls UDRE0 before it writes another.
+			processUsart();
+			const uint8_t miso = busTransfer(USART0_BUS, newValue);
+			uint64_t start = now;
+			if (!usartShifting.empty() &&
+					(usartShifting.back().doneNanos > start)) {
+				start = usartShifting.back().doneNanos;
+			}
+			usartShifting.push_back({ start + cyclesToNanos(
+				8UL * usartClockDivider() + UDR0_BYTE_OVERHEAD_CYCLES), miso });
+			UCSR0A.set(UCSR0A.get() & ~(1 << TXC0));
+			if (usartShifting.size() >= 2) {
+				UCSR0A.set(UCSR0A.get() & ~(1 << UDRE0));
+			}
+		}
+	}
+
+	uint8_t onRegisterRead(Register reg, uint8_t value) {
+		if (reg == REGISTER_UCSR0A) {
+			consume(static_cast<uint32_t>(cyclesToNanos(UCSR0A_POLL_CYCLES)));
+			return UCSR0A.get();
+		}
+		if ((reg != REGISTER_UDR0) || usartReceived.empty()) {
+			return value;
+		}
+		const uint8_t received = usartReceived.front();
+		usartReceived.pop_front();
+		if (usartReceived.empty()) {
+			UCSR0A.set(UCSR0A.get() & ~(1 << RXC0));
+		}
+		return received;
+	}
+
+	uint8_t spiTransfer(uint8_t data, uint8_t clockDivider,
+			uint8_t overheadCycles) {
+		const uint8_t miso = busTransfer(SPI_BUS, data);
+		consume(static_cast<uint32_t>(cyclesToNanos(
+			8UL * clockDivider + overheadCycles)));
+		return miso;
+	}
+
+	void onSerialTransmitStart() {
+		if (serialTxNextNanos < now) {
+			serialTxNextNanos = now;
+		}
+		serialTxNextNanos += serialByteNanos();
+	}
+
+	void attachSpiSlave(SpiSlave & slave, uint8_t portBPin, SpiBus bus) {
+		if (spiSlaveCount < MAX_SPI_SLAVES) {
+			spiSlaves[spiSlaveCount++] = { &slave, portBPin, bus, false };
+		}
+	}
+
+	void detachSpiSlaves() {
+		spiSlaveCount = 0;
+	}
+
+	void run(void (*loopFunction)(), uint32_t micros) {
+		const uint64_t end = now + 1000ULL * micros;
+		while (now < end) {
+			const uint64_t start = now;
+			loopFunction();
+			consume(LOOP_OVERHEAD_NANOS);
+			const uint64_t duration = now - start;
+			loopStatistics.count++;
+			if (duration > loopStatistics.maxNanos) {
+				loopStatistics.maxNanos = static_cast<uint32_t>(duration);
+			}
+		}
+	}
+
+	void skip(uint64_t nanos) {
+		now += nanos;
+		Timer1.lastOverflowNanos += nanos;
+		serialTxNextNanos += nanos;
+		serialRxNextNanos += nanos;
+	}
+
+	void hostWrite(const std::vector<uint8_t> & bytes) {
+		if (hostTx.empty() && (serialRxNextNanos < now)) {
+			serialRxNextNanos = now;
+		}
+		if (hostTx.empty() && (Serial.getBaud() != 0)) {
+			serialRxNextNanos += serialByteNanos();
+		}
+		hostTx.insert(hostTx.end(), bytes.begin(), bytes.end());
+	}
+
+	std::vector<uint8_t> & hostReceived() {
+		return hostRx;
+	}
+
+	bool isHostWritePending() {
+		return !hostTx.empty();
+	}
+
+	InterruptStats & interruptStats() {
+		return isrStats;
+	}
+
+	LoopStats & loopStats() {
+		return loopStatistics;
+	}
+
+	SerialStats & serialStats() {
+		return serialStatistics;
+	}
+
+	void resetStats() {
+		isrStats = InterruptStats();
+		loopStatistics = LoopStats();
+		serialStatistics = SerialStats();
+	}
+}
@@ -0,0 +1,147 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+/// <summary>
+/// Simulated Arduino Uno. It keeps the time of the CPU, dispatches the Timer1
+/// interrupt, routes the SPI bus to the attached slaves and connects the
+/// USART to a host computer.
+/// Simulated time only passes when the firmware spends it, i.e. SPI
+/// transfers, the overhead of loop() and interrupts, or waiting on the USART.
+/// </summary>
+namespace sim {
+
+	enum TimingModel {
+		// Entering and leaving the Timer1 interrupt including TimerOne.
+		ISR_OVERHEAD_NANOS = 4000,
+		// One iteration of loop() besides the work done by the firmware.
+		LOOP_OVERHEAD_NANOS = 10000,
+		// Bits per byte on the USART, i.e. 8N1.
+		SERIAL_BITS_PER_BYTE = 10,
+	};
+
+	/// <summary>
+	/// Device on the SPI bus selected by a pin of PORTB.
+	/// </summary>
+	struct SpiSlave {
+		virtual ~SpiSlave() { }
+		virtual void select() { }
+		virtual void deselect() { }
+		virtual uint8_t transfer(uint8_t mosi) = 0;
+	};
+
+	/// <summary>
+	/// Peripherals that shift bytes to the slaves.
+	/// </summary>
+	enum SpiBus {
+		SPI_BUS,    // The SPI, i.e. SPDR.
+		USART0_BUS, // USART0 in master SPI mode, i.e. UDR0.
+	};
+
+	uint64_t nanos();
+
+	void attachSpiSlave(SpiSlave & slave, uint8_t portBPin,
+		SpiBus bus = SPI_BUS);
+	void detachSpiSlaves();
+
+	/// <summary>
+	/// Run the firmware loop for the given simulated time.
+	/// </summary>
+	void run(void (*loopFunction)(), uint32_t micros);
+
+	/// <summary>
+	/// Let time pass without running the firmware, e.g. to get close to the
+	/// wrap around of millis(). Pending timer and USART events are moved along.
+	/// </summary>
+	void skip(uint64_t nanos);
+
+	// Host computer side of the USART.
+
+	/// <summary>
+	/// Send bytes to the firmware. They arrive at the baud rate, bytes that do
+	/// not fit into the receive buffer are lost.
+	/// </summary>
+	void hostWrite(const std::vector<uint8_t> & bytes);
+	/// <summary>
+	/// All bytes that have been transmitted by the firmware.
+	/// </summary>
+	std::vector<uint8_t> & hostReceived();
+	bool isHostWritePending();
+
+	struct InterruptStats {
+		uint32_t count;
+		uint64_t busyNanos;
+		uint32_t maxNanos;
+		// Interrupts that lasted beyond the next timer overflow.
+		uint32_t overruns;
+	};
+
+	struct LoopStats {
+		uint32_t count;
+		uint32_t maxNanos;
+	};
+
+	struct SerialStats {
+		uint32_t rxOverruns;
+		uint64_t txBytes;
+		// Time the firmware has been waiting for a full transmit buffer.
+		uint64_t txStallNanos;
+	};
+
+	InterruptStats & interruptStats();
+	LoopStats & loopStats();
+	SerialStats & serialStats();
+	void resetStats();
+}
+
+#endif // SIMULATOR_H
@@ -0,0 +1,211 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ARRANGE_GRID_FIXTURE_H
+#define ARRANGE_GRID_FIXTURE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "FirmataHost.h"
+#include "Mcp3008.h"
+#include "Simulator.h"
+
+// Sketch functions.
+void setup();
+void loop();
+
+/// <summary>
+/// The arrange grid sketch wired to the simulated ADCs of the row and column
+/// photoresistors like on the PCB. Each photoresistor reads the value given
+/// in the readings tables.
+/// </summary>
+namespace fixture {
+
+	enum Hardware {
+		ROWS                   = 8,
+		COLUMNS                = 8,
+		SAMPLE_PERIOD_MICROS   = 2000,
+		PIN_SS_LASER_ROWS      = 1,
+		PIN_SS_LASER_COLUMNS   = 2,
+		READING_BEAM           = 0x000,
+		READING_BROKEN         = 0x3FF,
+	};
+
+	// Protocol as seen from the host computer.
+	enum Protocol {
+		ROW_CHANGE_MESSAGE     = 0x0D,
+		COLUMN_CHANGE_MESSAGE  = 0x0C,
+		STREAM_STATS_MESSAGE   = 0x07,
+		TIMING_MESSAGE         = 0x05,
+		TIMING_SAMPLE_PERIOD   = 0x00,
+		TIMING_RUN             = 0x01,
+		TIMING_LATENCY         = 0x02,
+		TIMING_RESET           = 0x01,
+		PLACEMENT_MESSAGE      = 0x04,
+		PLACEMENT_REPORT       = 0x01,
+		BEAM_STATE_MESSAGE     = 0x03,
+		ROW_RESTORE_MESSAGE    = 0x02,
+		COLUMN_RESTORE_MESSAGE = 0x01,
+		SYSTEM_RESET           = 0xFF,
+	};
+
+	// Layout of a TIMING_MESSAGE reply.
+	enum TimingReply {
+		TIMING_COUNT,
+		TIMING_MIN,
+		TIMING_MAX,
+		TIMING_AVERAGE,
+		TIMING_HISTOGRAM,
+		HISTOGRAM_BUCKETS      = 8,
+		TIMING_VALUES          = TIMING_HISTOGRAM + HISTOGRAM_BUCKETS,
+		TIMING_BYTES           = TIMING_VALUES * 2,
+		ENCODED_TIMING_BYTES   = (TIMING_BYTES * 8 + 6) / 7,
+		// Time to receive the reply, as it may wait behind beam changes.
+		QUERY_MILLIS           = 20,
+	};
+
+	struct Timing {
+		uint8_t periodMillis;
+		std::vector<uint16_t> values;
+	};
+
+	static sim::Mcp3008 rowAdc;
+	static sim::Mcp3008 columnAdc;
+	static sim::FirmataHost host;
+	static uint16_t rowReadings[ROWS];
+	static uint16_t columnReadings[COLUMNS];
+
+	inline void runMillis(uint32_t millis) {
+		sim::run(loop, millis * 1000);
+	}
+
+	/// <summary>
+	/// Break the beams of a ship of the given tiles, or restore them.
+	/// </summary>
+	inline void setShip(uint8_t row, uint8_t column,
+			uint8_t rows, uint8_t columns, uint16_t reading) {
+		for (uint8_t r = row; r < row + rows; r++) {
+			rowReadings[ROWS - r - 1] = reading; // With reverse index order.
+		}
+		for (uint8_t c = column; c < column + columns; c++) {
+			columnReadings[c] = reading;
+		}
+	}
+
+	/// <summary>
+	/// Query a timing of the monitor. The values are empty if there has been
+	/// no valid reply.
+	/// </summary>
+	inline Timing queryTiming(uint8_t timing, uint8_t flags) {
+		host.sendSysex(TIMING_MESSAGE, { timing, flags });
+		runMillis(QUERY_MILLIS);
+		const std::vector<sim::FirmataHost::Message> replies =
+			host.receiveSysex(TIMING_MESSAGE);
+		Timing result = { 0, std::vector<uint16_t>() };
+		if ((replies.size() != 1) ||
+				(replies[0].data.size() != 2 + ENCODED_TIMING_BYTES) ||
+				(replies[0].data[0] != timing)) {
+			return result;
+		}
+		result.periodMillis = replies[0].data[1];
+		const std::vector<uint8_t> bytes = sim::FirmataHost::decode7Bit(
+			&replies[0].data[2], ENCODED_TIMING_BYTES, TIMING_BYTES);
+		for (size_t i = 0; i < TIMING_VALUES; i++) {
+			result.values.push_back(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// True if the timing has been replied and its values are consistent.
+	/// </summary>
+	inline bool isValid(const Timing & timing) {
+		const std::vector<uint16_t> & v = timing.values;
+		if (v.size() != TIMING_VALUES) {
+			return false;
+		}
+		uint32_t histogramCount = 0;
+		for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			histogramCount += v[TIMING_HISTOGRAM + i];
+		}
+		return (histogramCount == v[TIMING_COUNT]) &&
+			(v[TIMING_MIN] <= v[TIMING_AVERAGE]) &&
+			(v[TIMING_AVERAGE] <= v[TIMING_MAX]);
+	}
+
+	/// <summary>
+	/// Power on the board once per test program.
+	/// </summary>
+	inline void boot() {
+		static bool isBooted = false;
+		if (isBooted) {
+			return;
+		}
+		isBooted = true;
+		for (uint8_t i = 0; i < ROWS; i++) {
+			rowReadings[i] = READING_BEAM;
+		}
+		for (uint8_t i = 0; i < COLUMNS; i++) {
+			columnReadings[i] = READING_BEAM;
+		}
+		sim::attachSpiSlave(rowAdc, PIN_SS_LASER_ROWS);
+		sim::attachSpiSlave(columnAdc, PIN_SS_LASER_COLUMNS);
+		rowAdc.setSource([](uint8_t channel) {
+			return rowReadings[channel];
+		});
+		columnAdc.setSource([](uint8_t channel) {
+			return columnReadings[channel];
+		});
+		setup();
+		runMillis(100);
+		host.receive();
+	}
+}
+
+#endif // ARRANGE_GRID_FIXTURE_H
@@ -0,0 +1,134 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "ArrangeGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+
+	enum {
+		BEAM_BREAKS           = 5,
+		SAMPLES               = 500,
+	};
+}
+
+TEST(monitorsSamplePeriodAndRunTime) {
+	boot();
+	queryTiming(TIMING_SAMPLE_PERIOD, TIMING_RESET);
+	queryTiming(TIMING_RUN, TIMING_RESET);
+	sim::run(loop, SAMPLES * SAMPLE_PERIOD_MICROS);
+	const Timing period = queryTiming(TIMING_SAMPLE_PERIOD, 0x00);
+	const Timing run = queryTiming(TIMING_RUN, 0x00);
+	EXPECT_TRUE(isValid(period));
+	EXPECT_TRUE(isValid(run));
+	if (isValid(period) && isValid(run)) {
+		printf("  period %u ms + %u..%u us, run %u..%u us\n",
+			period.periodMillis, period.values[TIMING_MIN],
+			period.values[TIMING_MAX], run.values[TIMING_MIN],
+			run.values[TIMING_MAX]);
+		EXPECT_EQ(SAMPLE_PERIOD_MICROS / 1000, period.periodMillis);
+		// Counted over the samples and the time it took to query.
+		const uint16_t samplesPerQuery =
+			1000u * QUERY_MILLIS / SAMPLE_PERIOD_MICROS;
+		EXPECT_NEAR(SAMPLES + samplesPerQuery, period.values[TIMING_COUNT],
+			samplesPerQuery);
+		EXPECT_NEAR(SAMPLES + samplesPerQuery, run.values[TIMING_COUNT],
+			samplesPerQuery);
+		// Late by at most the time of a loop with a query.
+		EXPECT_TRUE(period.values[TIMING_MAX] <= SAMPLE_PERIOD_MICROS / 4);
+		EXPECT_TRUE(run.values[TIMING_MIN] > 0);
+		// Sampling leaves most of the time to the rest of the loop.
+		EXPECT_TRUE(run.values[TIMING_MAX] <= SAMPLE_PERIOD_MICROS / 4);
+	}
+}
+
+TEST(boundsLatencyFromBeamBreakToWire) {
+	boot();
+	queryTiming(TIMING_LATENCY, TIMING_RESET);
+	uint64_t worstNanos = 0;
+	for (uint8_t i = 0; i < BEAM_BREAKS; i++) {
+		// Break the beam at different times within the sample period.
+		sim::run(loop, SAMPLE_PERIOD_MICROS + 370 * i);
+		const uint64_t start = sim::nanos();
+		rowReadings[3] = READING_BROKEN;
+		size_t changes = 0;
+		while ((changes == 0) &&
+				(sim::nanos() - start < 3000ULL * SAMPLE_PERIOD_MICROS)) {
+			sim::run(loop, 10);
+			changes = host.receiveSysex(ROW_CHANGE_MESSAGE).size();
+		}
+		EXPECT_EQ(1u, changes);
+		if (sim::nanos() - start > worstNanos) {
+			worstNanos = sim::nanos() - start;
+		}
+		rowReadings[3] = READING_BEAM;
+		sim::run(loop, 2 * SAMPLE_PERIOD_MICROS);
+	}
+	const Timing latency = queryTiming(TIMING_LATENCY, TIMING_RESET);
+	EXPECT_TRUE(isValid(latency));
+	if (isValid(latency)) {
+		const uint32_t boundMicros =
+			latency.periodMillis * 1000u + latency.values[TIMING_MAX];
+		printf("  worst %u us observed, %u us reported\n",
+			static_cast<unsigned>(worstNanos / 1000),
+			static_cast<unsigned>(boundMicros));
+		EXPECT_EQ(BEAM_BREAKS, latency.values[TIMING_COUNT]);
+		// The monitor assumes the beam broke right after the previous
+		// sample, so it never reports less than has been observed.
+		EXPECT_TRUE(worstNanos / 1000 <= boundMicros);
+		// A sample period and the wire time of a change message.
+		EXPECT_TRUE(boundMicros < 2 * SAMPLE_PERIOD_MICROS);
+	}
+}
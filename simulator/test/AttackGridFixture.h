@@ -0,0 +1,170 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ATTACK_GRID_FIXTURE_H
+#define ATTACK_GRID_FIXTURE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "FirmataHost.h"
+#include "Mcp3008.h"
+#include "ShiftRegisterMatrix.h"
+#include "Simulator.h"
+
+// Sketch functions and objects.
+void setup();
+void loop();
+class CLEDController;
+extern CLEDController & ledMatrixController;
+
+/// <summary>
+/// The attack grid sketch wired to a simulated LED matrix and photodiode ADC
+/// like on the PCB. The photodiode of a tile reads the value given in the
+/// readings table while the column of the tile is lit.
+/// </summary>
+namespace fixture {
+
+	enum Hardware {
+		ROWS                    = 8,
+		COLUMNS                 = 8,
+		FPS                     = 100,
+		BITS_PER_COLOR          = 4,
+		FRAME_MICROS            = 1000000 / FPS,
+		PIN_SS_LED_MATRIX       = 2,
+		PIN_SS_PHOTODIODE_ARRAY = 1,
+		F_SCK_LED_MATRIX        = 8000000,
+		F_SCK_PHOTODIODE_ARRAY  = 2000000,
+		READING_LIT             = 0x3FF,
+		READING_COVERED         = 0x000,
+	};
+
+	// Protocol as seen from the host computer.
+	enum Protocol {
+		STRING_DATA               = 0x71,
+		REPORT_FIRMWARE           = 0x79,
+		REPORT_VERSION            = 0xF9,
+		SYSTEM_RESET              = 0xFF,
+		TILE_TYPE_MESSAGE         = 0x0F,
+		TILE_CHANGE_MESSAGE       = 0x0E,
+		TILE_CHANGE_FRAME_MESSAGE = 0x0B,
+		GRID_CONFIG_MESSAGE       = 0x0A,
+		TILE_TYPE_BULK_MESSAGE    = 0x09,
+		TILE_TYPE_ACK_MESSAGE     = 0x08,
+		STREAM_STATS_MESSAGE      = 0x07,
+		PROFILE_MESSAGE           = 0x06,
+		GRID_CONFIG_QUERY         = 0x00,
+		GRID_CONFIG_SET_FEATURES  = 0x01,
+		GRID_CONFIG_REPLY         = 0x02,
+		FEATURE_TILE_CHANGE_FRAME = 0x01,
+		FEATURE_TILE_TYPE_ACK     = 0x02,
+		STREAM_STATS_RESET        = 0x01,
+		PROFILE_RESET             = 0x01,
+	};
+
+	enum TileType {
+		NONE      = 0x00,
+		WATER     = 0x01,
+		HIT       = 0x02,
+		DESTROYED = 0x03,
+	};
+
+	static sim::ShiftRegisterMatrix matrix;
+	static sim::Mcp3008 adc;
+	static sim::FirmataHost host;
+	static uint16_t readings[ROWS][COLUMNS];
+	static std::vector<sim::FirmataHost::Message> startupMessages;
+	static std::vector<sim::ShiftRegisterMatrix::Latch> startupLatches;
+
+	inline void runFrames(uint32_t frames) {
+		sim::run(loop, frames * FRAME_MICROS);
+	}
+
+	/// <summary>
+	/// Power on the board once per test program.
+	/// </summary>
+	inline void boot() {
+		static bool isBooted = false;
+		if (isBooted) {
+			return;
+		}
+		isBooted = true;
+		for (uint8_t row = 0; row < ROWS; row++) {
+			for (uint8_t column = 0; column < COLUMNS; column++) {
+				readings[row][column] = READING_LIT;
+			}
+		}
+		sim::attachSpiSlave(matrix, PIN_SS_LED_MATRIX);
+		sim::attachSpiSlave(adc, PIN_SS_PHOTODIODE_ARRAY);
+		adc.setSource([](uint8_t channel) {
+			const int column = matrix.activeColumn();
+			return (column < 0) ? 0 : readings[channel][column];
+		});
+		setup();
+		runFrames(2);
+		startupMessages = host.receive();
+		startupLatches = matrix.latches();
+	}
+
+	inline void setFeatures(uint8_t features) {
+		host.sendSysex(GRID_CONFIG_MESSAGE,
+			{ GRID_CONFIG_SET_FEATURES, features });
+		runFrames(2);
+		host.receive();
+	}
+
+	inline void setAllReadings(uint16_t value) {
+		for (uint8_t row = 0; row < ROWS; row++) {
+			for (uint8_t column = 0; column < COLUMNS; column++) {
+				readings[row][column] = value;
+			}
+		}
+	}
+}
+
+#endif // ATTACK_GRID_FIXTURE_H
@@ -0,0 +1,137 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <vector>
+
+#include "ArrangeGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+
+	enum {
+		BEAM_STATE_BYTES         = 2,
+		ENCODED_BEAM_STATE_BYTES = (BEAM_STATE_BYTES * 8 + 6) / 7,
+		// Time to sample a change and to receive its messages.
+		SETTLE_MILLIS            = 20,
+	};
+
+	std::vector<uint8_t> positions(const std::vector<Message> & messages,
+			uint8_t command) {
+		std::vector<uint8_t> result;
+		for (size_t i = 0; i < messages.size(); i++) {
+			if ((messages[i].command == command) &&
+					(messages[i].data.size() == 1)) {
+				result.push_back(messages[i].data[0]);
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Query the beam state, the result is empty if there has been no valid
+	/// reply.
+	/// </summary>
+	std::vector<uint8_t> queryBeamState() {
+		host.sendSysex(BEAM_STATE_MESSAGE, {});
+		runMillis(SETTLE_MILLIS);
+		const std::vector<Message> replies =
+			host.receiveSysex(BEAM_STATE_MESSAGE);
+		EXPECT_EQ(1u, replies.size());
+		if ((replies.size() != 1) ||
+				(replies[0].data.size() != ENCODED_BEAM_STATE_BYTES)) {
+			return std::vector<uint8_t>();
+		}
+		return sim::FirmataHost::decode7Bit(&replies[0].data[0],
+			ENCODED_BEAM_STATE_BYTES, BEAM_STATE_BYTES);
+	}
+}
+
+TEST(reportsBrokenAndRestoredBeams) {
+	boot();
+	setShip(6, 3, 1, 2, READING_BROKEN);
+	runMillis(SETTLE_MILLIS);
+	const std::vector<Message> broken = host.receive();
+	EXPECT_TRUE(positions(broken, ROW_CHANGE_MESSAGE) ==
+		std::vector<uint8_t>({ 6 }));
+	EXPECT_TRUE(positions(broken, COLUMN_CHANGE_MESSAGE) ==
+		std::vector<uint8_t>({ 3, 4 }));
+	EXPECT_TRUE(positions(broken, ROW_RESTORE_MESSAGE).empty());
+	// Lifting the ship restores the same beams.
+	setShip(6, 3, 1, 2, READING_BEAM);
+	runMillis(SETTLE_MILLIS);
+	const std::vector<Message> restored = host.receive();
+	EXPECT_TRUE(positions(restored, ROW_RESTORE_MESSAGE) ==
+		std::vector<uint8_t>({ 6 }));
+	EXPECT_TRUE(positions(restored, COLUMN_RESTORE_MESSAGE) ==
+		std::vector<uint8_t>({ 3, 4 }));
+	EXPECT_TRUE(positions(restored, ROW_CHANGE_MESSAGE).empty());
+}
+
+TEST(resynchronisesWithOneQuery) {
+	boot();
+	setShip(0, 7, 3, 1, READING_BROKEN);
+	setShip(5, 1, 1, 4, READING_BROKEN);
+	runMillis(SETTLE_MILLIS);
+	// A host that reconnects has missed the changes.
+	host.receive();
+	const std::vector<uint8_t> state = queryBeamState();
+	EXPECT_EQ(2u, state.size());
+	if (state.size() == 2) {
+		EXPECT_EQ(0x27, state[0]); // Rows 0..2 and 5.
+		EXPECT_EQ(0x9E, state[1]); // Columns 1..4 and 7.
+	}
+	setShip(0, 0, ROWS, COLUMNS, READING_BEAM);
+	runMillis(SETTLE_MILLIS);
+	host.receive();
+	const std::vector<uint8_t> cleared = queryBeamState();
+	EXPECT_TRUE(cleared == std::vector<uint8_t>({ 0x00, 0x00 }));
+}
@@ -0,0 +1,200 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "AttackGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+
+	enum {
+		BITMAP_BYTES         = 8,
+		ENCODED_BITMAP_BYTES = (BITMAP_BYTES * 8 + 6) / 7,
+		// Calibration of the photodiode of tile (2, 5) with a threshold of
+		// 310 and a hysteresis band of 292 to 328.
+		HYSTERESIS_ROW       = 2,
+		HYSTERESIS_COLUMN    = 5,
+		HYSTERESIS_LOW       = 292,
+		HYSTERESIS_HIGH      = 328,
+	};
+
+	void setReading(uint8_t row, uint8_t column, uint16_t value) {
+		readings[row][column] = value;
+		runFrames(3);
+	}
+}
+
+TEST(reportsCoveredTileOnce) {
+	boot();
+	setReading(4, 3, READING_COVERED);
+	std::vector<Message> changes = host.receiveSysex(TILE_CHANGE_MESSAGE);
+	EXPECT_EQ(1u, changes.size());
+	if (changes.size() == 1) {
+		const std::vector<uint8_t> expected = { 4, 3 };
+		EXPECT_TRUE(changes[0].data == expected);
+	}
+	runFrames(5);
+	setReading(4, 3, READING_LIT);
+	EXPECT_EQ(0u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+}
+
+TEST(ignoresSelectedRow) {
+	boot();
+	setReading(0, 6, READING_COVERED);
+	setReading(0, 6, READING_LIT);
+	EXPECT_EQ(0u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+}
+
+TEST(hysteresisSuppressesNoise) {
+	boot();
+	const uint8_t row = HYSTERESIS_ROW;
+	const uint8_t column = HYSTERESIS_COLUMN;
+	// Noise within the band never crosses the lower threshold.
+	for (uint8_t i = 0; i < 4; i++) {
+		setReading(row, column, HYSTERESIS_LOW + 8);
+		setReading(row, column, HYSTERESIS_HIGH - 8);
+	}
+	EXPECT_EQ(0u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+	setReading(row, column, HYSTERESIS_LOW - 1);
+	EXPECT_EQ(1u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+	// Once low, it takes a reading above the upper threshold to re-arm.
+	setReading(row, column, HYSTERESIS_HIGH - 8);
+	setReading(row, column, HYSTERESIS_LOW - 1);
+	EXPECT_EQ(0u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+	setReading(row, column, HYSTERESIS_HIGH + 1);
+	setReading(row, column, HYSTERESIS_LOW - 1);
+	EXPECT_EQ(1u, host.receiveSysex(TILE_CHANGE_MESSAGE).size());
+	setReading(row, column, READING_LIT);
+}
+
+TEST(reportsChangesOfAFrameAsOneBitmap) {
+	boot();
+	setFeatures(FEATURE_TILE_CHANGE_FRAME);
+	readings[1][1] = READING_COVERED;
+	readings[4][6] = READING_COVERED;
+	readings[7][0] = READING_COVERED;
+	runFrames(3);
+	const std::vector<Message> messages = host.receive();
+	// The tiles have been covered in the middle of a frame, so the changes
+	// are spread over the two frames it took to sense all columns.
+	std::vector<Message> frames;
+	for (size_t i = 0; i < messages.size(); i++) {
+		EXPECT_EQ(TILE_CHANGE_FRAME_MESSAGE, messages[i].command);
+		if (messages[i].command == TILE_CHANGE_FRAME_MESSAGE) {
+			frames.push_back(messages[i]);
+		}
+	}
+	EXPECT_TRUE((frames.size() == 1) || (frames.size() == 2));
+	std::vector<uint8_t> changed(BITMAP_BYTES, 0x00);
+	for (size_t i = 0; i < frames.size(); i++) {
+		EXPECT_EQ(ENCODED_BITMAP_BYTES + 1u, frames[i].data.size());
+		const std::vector<uint8_t> bitmap = sim::FirmataHost::decode7Bit(
+			frames[i].data.data(), ENCODED_BITMAP_BYTES, BITMAP_BYTES);
+		for (uint8_t column = 0; column < BITMAP_BYTES; column++) {
+			EXPECT_EQ(0, changed[column] & bitmap[column]);
+			changed[column] |= bitmap[column];
+		}
+	}
+	if (frames.size() == 2) {
+		const uint8_t first = frames[0].data[ENCODED_BITMAP_BYTES];
+		const uint8_t second = frames[1].data[ENCODED_BITMAP_BYTES];
+		EXPECT_EQ((first + 1) & 0x7F, second);
+	}
+	const std::vector<uint8_t> expected = {
+		1 << 7, 1 << 1, 0, 0, 0, 0, 1 << 4, 0
+	};
+	EXPECT_TRUE(changed == expected);
+	setAllReadings(READING_LIT);
+	runFrames(3);
+	setFeatures(0x00);
+}
+
+TEST(bitmapReducesTrafficOfManyChanges) {
+	boot();
+	const size_t tiles = (ROWS - 1) * COLUMNS;
+	size_t messageCount[2];
+	uint64_t bytes[2];
+	uint64_t stallNanos[2];
+	for (uint8_t frameMessage = 0; frameMessage < 2; frameMessage++) {
+		setFeatures(frameMessage ? FEATURE_TILE_CHANGE_FRAME : 0x00);
+		sim::resetStats();
+		// Cover everything but the selected row at once.
+		for (uint8_t row = 1; row < ROWS; row++) {
+			for (uint8_t column = 0; column < COLUMNS; column++) {
+				readings[row][column] = READING_COVERED;
+			}
+		}
+		runFrames(10);
+		bytes[frameMessage] = sim::serialStats().txBytes;
+		stallNanos[frameMessage] = sim::serialStats().txStallNanos;
+		messageCount[frameMessage] = host.receive().size();
+		setAllReadings(READING_LIT);
+		runFrames(3);
+	}
+	printf("  %u of %u changes in %u bytes per message vs. "
+		"all in %u bytes per frame\n",
+		static_cast<unsigned>(messageCount[0]),
+		static_cast<unsigned>(tiles),
+		static_cast<unsigned>(bytes[0]),
+		static_cast<unsigned>(bytes[1]));
+	// The serial port cannot take a message per change at once, so the
+	// changes wait for room instead of stalling the loop or being dropped.
+	EXPECT_EQ(tiles, messageCount[0]);
+	EXPECT_EQ(messageCount[0] * 5u, bytes[0]);
+	EXPECT_TRUE((messageCount[1] == 1) || (messageCount[1] == 2));
+	EXPECT_TRUE(bytes[1] < tiles * 5u / 4);
+	EXPECT_EQ(0u, stallNanos[0]);
+	EXPECT_EQ(0u, stallNanos[1]);
+	setFeatures(0x00);
+}
@@ -0,0 +1,300 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "Mcp3008.h"
+#include "ShiftRegisterMatrix.h"
+#include "Simulator.h"
+#include "Test.h"
+
+// After the C++ library, as the core defines min() and max() as macros.
+#include <Arduino.h>
+#include "AttackGrid.h"
+#include "RgbLedMatrix.h"
+#include "RgbLedPhotodiodeArray.h"
+#include "SpiDevicePortB.h"
+#include "SpiDeviceUsart0.h"
+
+namespace {
+
+	enum {
+		ROWS                    = 8,
+		COLUMNS                 = 8,
+		FPS                     = 100,
+		BITS_PER_COLOR          = 4,
+		FRAME_MICROS            = 1000000 / FPS,
+		PIN_SS_LED_MATRIX       = PB2,
+		F_SCK_LED_MATRIX        = 8000000,
+		PIN_SS_PHOTODIODE_ARRAY = PB1,
+		F_SCK_PHOTODIODE_ARRAY  = 2000000,
+		BCM_BASE_MICROS   = FRAME_MICROS / COLUMNS / ((1 << BITS_PER_COLOR) - 1),
+		LATCHES_PER_COLUMN = BITS_PER_COLOR,
+	};
+
+	/// <summary>
+	/// LED matrix that remembers when the last byte of each latched column
+	/// has been written.
+	/// </summary>
+	class TappedMatrix : public sim::ShiftRegisterMatrix {
+
+		uint64_t lastByteNanos;
+
+	public:
+		std::vector<uint64_t> lastByteOfLatch;
+
+		TappedMatrix() : lastByteNanos(0) { }
+
+		uint8_t transfer(uint8_t mosi) {
+			lastByteNanos = sim::nanos();
+			return ShiftRegisterMatrix::transfer(mosi);
+		}
+
+		void deselect() {
+			ShiftRegisterMatrix::deselect();
+			lastByteOfLatch.push_back(lastByteNanos);
+		}
+
+		void clear() {
+			clearLatches();
+			lastByteOfLatch.clear();
+		}
+	};
+
+	// The LED matrix on USART0, the photodiodes on the SPI.
+	typedef AttackGrid<
+		RgbLedMatrix<SpiDeviceUsart0<PIN_SS_LED_MATRIX, F_SCK_LED_MATRIX> >,
+		RgbLedPhotodiodeArray<
+			SpiDevicePortB<PIN_SS_PHOTODIODE_ARRAY, F_SCK_PHOTODIODE_ARRAY>
+		>,
+		ROWS, COLUMNS, FPS, BITS_PER_COLOR
+	> Grid;
+
+	TappedMatrix matrix;
+	sim::Mcp3008 adc;
+	// Column that has been lit during each conversion.
+	std::vector<int> convertedColumns;
+
+	typedef sim::ShiftRegisterMatrix::Latch Latch;
+
+	void loop() {
+		Grid::run();
+	}
+
+	void runOneSecond() {
+		static bool isBegun = false;
+		if (!isBegun) {
+			isBegun = true;
+			sim::attachSpiSlave(matrix, PIN_SS_LED_MATRIX, sim::USART0_BUS);
+			sim::attachSpiSlave(adc, PIN_SS_PHOTODIODE_ARRAY);
+			adc.setSource([](uint8_t channel) {
+				convertedColumns.push_back(matrix.activeColumn());
+				return static_cast<uint16_t>(sim::Mcp3008::READING_MAX);
+			});
+			Serial.begin(57600);
+			Firmata.begin(Serial);
+			Grid::begin();
+		}
+		sim::run(loop, FRAME_MICROS);
+		matrix.clear();
+		adc.clearConversions();
+		convertedColumns.clear();
+		sim::resetStats();
+		sim::run(loop, FPS * FRAME_MICROS);
+	}
+
+	/// <summary>
+	/// Index of the first latch of the first complete frame.
+	/// </summary>
+	size_t firstFrameStart(const std::vector<Latch> & latches) {
+		for (size_t i = 1; i < latches.size(); i++) {
+			if ((latches[i].columns == 0x01) &&
+					(latches[i - 1].columns != 0x01)) {
+				return i;
+			}
+		}
+		return latches.size();
+	}
+}
+
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+const typename AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::TileStyle AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::tileStyles[] = {
+	{ 0x00FFFF, false }, // NONE
+	{ 0x0000FF, false }, // WATER
+	{ 0xFFFF00, false }, // HIT
+	{ 0xFF0000, true  }, // DESTROYED
+	{ 0x00FFFF, false }, // SELECTED
+};
+
+// Default calibrations, the photodiodes are always lit.
+template<
+	typename RgbLedMatrix,
+	typename RgbLedPhotodiodeArray,
+	uint8_t MAX_ROWS, uint8_t MAX_COLUMNS,
+	uint8_t FPS,
+	uint8_t BITS_PER_COLOR
+>
+PhotodiodeBank<MAX_ROWS> AttackGrid<
+	RgbLedMatrix,
+	RgbLedPhotodiodeArray,
+	MAX_ROWS, MAX_COLUMNS,
+	FPS,
+	BITS_PER_COLOR
+>::photodiodeBanks[MAX_COLUMNS];
+
+TEST(latchesEachColumnOncePerBit) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const size_t start = firstFrameStart(latches);
+	EXPECT_NEAR(FPS * COLUMNS * LATCHES_PER_COLUMN, latches.size(),
+		COLUMNS * LATCHES_PER_COLUMN);
+	for (size_t i = start; i < latches.size(); i++) {
+		const uint8_t column = ((i - start) / LATCHES_PER_COLUMN) % COLUMNS;
+		EXPECT_EQ(1 << column, latches[i].columns);
+	}
+}
+
+TEST(latchesTheShiftedColumnOnTime) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const size_t start = firstFrameStart(latches);
+	uint32_t maxErrorNanos = 0;
+	for (size_t i = start; i + 1 < latches.size(); i++) {
+		const uint8_t bit = (i - start) % LATCHES_PER_COLUMN;
+		const int64_t expectedNanos = (BCM_BASE_MICROS << bit) * 1000LL;
+		const int64_t intervalNanos = latches[i + 1].nanos - latches[i].nanos;
+		const int64_t errorNanos = (intervalNanos > expectedNanos)
+			? (intervalNanos - expectedNanos) : (expectedNanos - intervalNanos);
+		if (errorNanos > maxErrorNanos) {
+			maxErrorNanos = static_cast<uint32_t>(errorNanos);
+		}
+	}
+	printf("  max error %u ns\n", static_cast<unsigned>(maxErrorNanos));
+	EXPECT_TRUE(maxErrorNanos < 1000);
+}
+
+TEST(shiftsTheNextColumnWhileSensing) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const std::vector<sim::Mcp3008::Conversion> & conversions =
+		adc.conversions();
+	const size_t start = firstFrameStart(latches);
+	uint32_t shifted = 0;
+	uint32_t misplaced = 0;
+	size_t conversion = 0;
+	while ((conversion < conversions.size()) && (start < latches.size()) &&
+			(conversions[conversion].nanos < latches[start].nanos)) {
+		conversion++;
+	}
+	for (size_t i = start + 1; i < latches.size(); i++) {
+		const bool isFirstBit = ((i - start) % LATCHES_PER_COLUMN) == 0;
+		// Conversions between the last byte of the column and its latch.
+		uint32_t sensed = 0;
+		while ((conversion < conversions.size()) &&
+				(conversions[conversion].nanos < latches[i].nanos)) {
+			if (conversions[conversion].nanos > matrix.lastByteOfLatch[i]) {
+				sensed++;
+			}
+			conversion++;
+		}
+		if (isFirstBit) {
+			// Shifted before the sweep of the previous column was over.
+			shifted += (sensed > 0);
+			misplaced += (sensed == 0);
+		} else {
+			misplaced += (sensed > 0);
+		}
+	}
+	printf("  %u columns shifted while sensing\n",
+		static_cast<unsigned>(shifted));
+	EXPECT_NEAR(FPS * COLUMNS, shifted, 2 * COLUMNS);
+	EXPECT_EQ(0u, misplaced);
+}
+
+TEST(sensesTheShownColumn) {
+	runOneSecond();
+	EXPECT_NEAR(FPS * COLUMNS * ROWS, convertedColumns.size(), COLUMNS * ROWS);
+	// Each sweep converts all rows of one column, then the next column.
+	uint32_t misplaced = 0;
+	for (size_t i = ROWS; i < convertedColumns.size(); i++) {
+		const int previous = convertedColumns[i - 1];
+		const int expected = ((i % ROWS) == 0) ? (previous + 1) % COLUMNS
+			: previous;
+		misplaced += (convertedColumns[i] != expected);
+	}
+	EXPECT_EQ(0u, misplaced);
+}
+
+TEST(interruptsNeverOverrun) {
+	runOneSecond();
+	const sim::InterruptStats & stats = sim::interruptStats();
+	printf("  %u interrupts, longest %u ns\n",
+		static_cast<unsigned>(stats.count),
+		static_cast<unsigned>(stats.maxNanos));
+	EXPECT_EQ(0u, stats.overruns);
+}
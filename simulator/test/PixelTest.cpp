@@ -0,0 +1,172 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+
+#include "AttackGridFixture.h"
+#include "Test.h"
+
+#include <FastLED.h>
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::ShiftRegisterMatrix Matrix;
+
+	enum {
+		PIXELS = ROWS * COLUMNS,
+		// Levels of a channel shown by binary code modulation.
+		LEVELS = (1 << BITS_PER_COLOR) - 1,
+	};
+
+	CRGB leds[PIXELS];
+
+	void fill(const CRGB & color) {
+		for (uint8_t i = 0; i < PIXELS; i++) {
+			leds[i] = color;
+		}
+	}
+
+	void show() {
+		static bool isAdded = false;
+		if (!isAdded) {
+			FastLED.addLeds(&ledMatrixController, leds, PIXELS);
+			isAdded = true;
+		}
+		FastLED.show();
+	}
+
+	char shownAt(const std::string & shown, uint8_t row, uint8_t column) {
+		// Rows are rendered top down, one line per row.
+		return shown[row * (COLUMNS + 1) + column];
+	}
+}
+
+TEST(showsPixelsWithBinaryCodeModulation) {
+	boot();
+	fill(CRGB::Black);
+	leds[2 * COLUMNS + 3] = CRGB(0x00, 0xFF, 0x00);
+	leds[2 * COLUMNS + 4] = CRGB(0x00, 0x80, 0x00);
+	leds[2 * COLUMNS + 5] = CRGB(0x00, 0x10, 0x00);
+	show();
+	runFrames(2);
+	matrix.clearIntegration();
+	runFrames(10);
+	const double full = matrix.dutyCycle(2, 3, Matrix::GREEN);
+	const double half = matrix.dutyCycle(2, 4, Matrix::GREEN);
+	const double least = matrix.dutyCycle(2, 5, Matrix::GREEN);
+	printf("  duty cycle %.4f, %.4f, %.4f\n", full, half, least);
+	EXPECT_TRUE(full > 0.0);
+	// Only the most significant bits of a channel are shown.
+	EXPECT_TRUE(fabs(half / full - 8.0 / LEVELS) < 0.05);
+	EXPECT_TRUE(fabs(least / full - 1.0 / LEVELS) < 0.02);
+	EXPECT_EQ(0.0, matrix.dutyCycle(2, 3, Matrix::RED));
+	EXPECT_EQ(0.0, matrix.dutyCycle(3, 3, Matrix::GREEN));
+}
+
+TEST(tilesDrawOverPixels) {
+	boot();
+	fill(CRGB::Blue);
+	show();
+	runFrames(2);
+	host.sendSysex(TILE_TYPE_MESSAGE, { HIT, 1, 1 });
+	runFrames(2);
+	host.receive();
+	matrix.clearIntegration();
+	runFrames(5);
+	std::string shown = matrix.render();
+	printf("%s", shown.c_str());
+	EXPECT_EQ('Y', shownAt(shown, 1, 1));
+	EXPECT_EQ('B', shownAt(shown, 1, 2));
+	EXPECT_EQ('B', shownAt(shown, 6, 6));
+	// The next show keeps the tile.
+	show();
+	runFrames(2);
+	matrix.clearIntegration();
+	runFrames(5);
+	shown = matrix.render();
+	EXPECT_EQ('Y', shownAt(shown, 1, 1));
+	EXPECT_EQ('B', shownAt(shown, 1, 2));
+}
+
+TEST(keepsBlinkingTilesAcrossShows) {
+	boot();
+	host.sendSysex(TILE_TYPE_MESSAGE, { DESTROYED, 4, 4 });
+	runFrames(2);
+	host.receive();
+	fill(CRGB(0x00, 0xFF, 0x00));
+	show();
+	runFrames(2);
+	matrix.clearIntegration();
+	runFrames(FPS);
+	const std::string shown = matrix.render();
+	printf("%s", shown.c_str());
+	EXPECT_EQ('R', shownAt(shown, 4, 4));
+	EXPECT_EQ('G', shownAt(shown, 4, 5));
+	// Blinks at half the duty cycle of a steady tile.
+	const double red = matrix.dutyCycle(4, 4, Matrix::RED);
+	const double green = matrix.dutyCycle(4, 5, Matrix::GREEN);
+	printf("  duty cycle %.4f, %.4f\n", red, green);
+	EXPECT_TRUE(fabs(red / green - 0.5) < 0.1);
+}
+
+TEST(keepsRedDarkOnUntouchedTiles) {
+	boot();
+	fill(CRGB::White);
+	show();
+	runFrames(2);
+	matrix.clearIntegration();
+	runFrames(5);
+	const std::string shown = matrix.render();
+	printf("%s", shown.c_str());
+	EXPECT_EQ('C', shownAt(shown, 5, 2));
+	EXPECT_EQ(0.0, matrix.dutyCycle(5, 2, Matrix::RED));
+}
@@ -0,0 +1,241 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "ArrangeGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+
+	enum {
+		PLACEMENT_BYTES         = 2 + 2 * ROWS,
+		ENCODED_PLACEMENT_BYTES = (PLACEMENT_BYTES * 8 + 6) / 7,
+		// Time to sample a change and to receive its report.
+		SETTLE_MILLIS           = 20,
+	};
+
+	struct Placement {
+		uint8_t rowMask;
+		uint8_t columnMask;
+		std::vector<uint8_t> occupied;
+		std::vector<uint8_t> ambiguous;
+	};
+
+	Placement decode(const Message & message) {
+		Placement placement = { 0, 0, {}, {} };
+		EXPECT_EQ(static_cast<size_t>(ENCODED_PLACEMENT_BYTES),
+			message.data.size());
+		if (message.data.size() != ENCODED_PLACEMENT_BYTES) {
+			return placement;
+		}
+		const std::vector<uint8_t> bytes = sim::FirmataHost::decode7Bit(
+			&message.data[0], ENCODED_PLACEMENT_BYTES, PLACEMENT_BYTES);
+		placement.rowMask = bytes[0];
+		placement.columnMask = bytes[1];
+		placement.occupied.assign(&bytes[2], &bytes[2 + ROWS]);
+		placement.ambiguous.assign(&bytes[2 + ROWS], &bytes[2 + 2 * ROWS]);
+		return placement;
+	}
+
+	void clearShips() {
+		setShip(0, 0, ROWS, COLUMNS, READING_BEAM);
+		runMillis(SETTLE_MILLIS);
+		host.receive();
+	}
+
+	/// <summary>
+	/// Opt in to placement reports and tell the current placement.
+	/// </summary>
+	Placement enableReports() {
+		host.sendSysex(PLACEMENT_MESSAGE, { PLACEMENT_REPORT });
+		runMillis(SETTLE_MILLIS);
+		const std::vector<Message> replies =
+			host.receiveSysex(PLACEMENT_MESSAGE);
+		EXPECT_EQ(1u, replies.size());
+		return replies.empty() ? Placement() : decode(replies.back());
+	}
+
+	Placement settle() {
+		runMillis(SETTLE_MILLIS);
+		const std::vector<Message> reports =
+			host.receiveSysex(PLACEMENT_MESSAGE);
+		EXPECT_EQ(1u, reports.size());
+		return reports.empty() ? Placement() : decode(reports.back());
+	}
+
+	size_t count(const std::vector<Message> & messages, uint8_t command) {
+		size_t result = 0;
+		for (size_t i = 0; i < messages.size(); i++) {
+			if (messages[i].command == command) {
+				result++;
+			}
+		}
+		return result;
+	}
+
+	uint8_t bits(uint8_t first, uint8_t count) {
+		return ((1 << count) - 1) << first;
+	}
+}
+
+TEST(reportsSingleShipAsCertain) {
+	boot();
+	clearShips();
+	const Placement empty = enableReports();
+	EXPECT_EQ(0, empty.rowMask);
+	EXPECT_EQ(0, empty.columnMask);
+	setShip(2, 1, 1, 3, READING_BROKEN);
+	const Placement placement = settle();
+	EXPECT_EQ(bits(2, 1), placement.rowMask);
+	EXPECT_EQ(bits(1, 3), placement.columnMask);
+	for (uint8_t row = 0; row < ROWS && placement.occupied.size(); row++) {
+		EXPECT_EQ(row == 2 ? bits(1, 3) : 0, placement.occupied[row]);
+		EXPECT_EQ(0, placement.ambiguous[row]);
+	}
+}
+
+TEST(marksParallelShipsAsAmbiguous) {
+	boot();
+	clearShips();
+	enableReports();
+	setShip(1, 0, 1, 3, READING_BROKEN);
+	setShip(5, 4, 1, 3, READING_BROKEN);
+	const Placement placement = settle();
+	// Either ship may be in either row.
+	const uint8_t columns = bits(0, 3) | bits(4, 3);
+	for (uint8_t row = 0; row < ROWS && placement.occupied.size(); row++) {
+		const uint8_t expected = (row == 1 || row == 5) ? columns : 0;
+		EXPECT_EQ(expected, placement.occupied[row]);
+		EXPECT_EQ(expected, placement.ambiguous[row]);
+	}
+}
+
+TEST(resolvesShipsAlongBothAxes) {
+	boot();
+	clearShips();
+	enableReports();
+	setShip(1, 0, 1, 3, READING_BROKEN);
+	setShip(3, 6, 3, 1, READING_BROKEN);
+	const Placement placement = settle();
+	for (uint8_t row = 0; row < ROWS && placement.occupied.size(); row++) {
+		uint8_t expected = 0;
+		if (row == 1) {
+			expected = bits(0, 3);
+		} else if (row >= 3 && row <= 5) {
+			expected = bits(6, 1);
+		}
+		EXPECT_EQ(expected, placement.occupied[row]);
+		EXPECT_EQ(0, placement.ambiguous[row]);
+	}
+}
+
+TEST(replacesBeamChangesWhenEnabled) {
+	boot();
+	clearShips();
+	enableReports();
+	setShip(4, 2, 1, 4, READING_BROKEN);
+	runMillis(SETTLE_MILLIS);
+	const std::vector<Message> messages = host.receive();
+	const size_t beamChanges = count(messages, ROW_CHANGE_MESSAGE) +
+		count(messages, COLUMN_CHANGE_MESSAGE);
+	const size_t placements = count(messages, PLACEMENT_MESSAGE);
+	printf("  1 placement report instead of 5 beam changes\n");
+	EXPECT_EQ(0u, beamChanges);
+	EXPECT_EQ(1u, placements);
+	// Lifting the ship is reported as well.
+	setShip(4, 2, 1, 4, READING_BEAM);
+	const Placement placement = settle();
+	EXPECT_EQ(0, placement.rowMask);
+	EXPECT_EQ(0, placement.columnMask);
+	// Opting out restores the beam changes.
+	host.sendSysex(PLACEMENT_MESSAGE, { 0x00 });
+	runMillis(SETTLE_MILLIS);
+	host.receive();
+	setShip(4, 2, 1, 4, READING_BROKEN);
+	runMillis(SETTLE_MILLIS);
+	const std::vector<Message> changes = host.receive();
+	EXPECT_EQ(1u, count(changes, ROW_CHANGE_MESSAGE));
+	EXPECT_EQ(4u, count(changes, COLUMN_CHANGE_MESSAGE));
+	EXPECT_EQ(0u, count(changes, PLACEMENT_MESSAGE));
+}
+
+TEST(startsNewSessionOnSystemReset) {
+	boot();
+	clearShips();
+	enableReports();
+	// The statistics count all samples since they have been reset last.
+	runMillis(100 * SETTLE_MILLIS);
+	const Timing before = queryTiming(TIMING_SAMPLE_PERIOD, 0x00);
+	host.send({ SYSTEM_RESET });
+	runMillis(SETTLE_MILLIS);
+	host.receive();
+	const Timing after = queryTiming(TIMING_SAMPLE_PERIOD, 0x00);
+	EXPECT_TRUE(isValid(before));
+	EXPECT_TRUE(isValid(after));
+	if (isValid(before) && isValid(after)) {
+		// Only the samples of the new session, while waiting for replies.
+		const uint16_t samples =
+			1000u * (SETTLE_MILLIS + QUERY_MILLIS) / SAMPLE_PERIOD_MICROS;
+		EXPECT_TRUE(before.values[TIMING_COUNT] > 1000);
+		EXPECT_TRUE(after.values[TIMING_COUNT] <= samples + 1);
+	}
+	// A new host session gets the beam changes until it opts in again.
+	setShip(4, 2, 1, 4, READING_BROKEN);
+	runMillis(SETTLE_MILLIS);
+	const std::vector<Message> changes = host.receive();
+	EXPECT_EQ(1u, count(changes, ROW_CHANGE_MESSAGE));
+	EXPECT_EQ(4u, count(changes, COLUMN_CHANGE_MESSAGE));
+	EXPECT_EQ(0u, count(changes, PLACEMENT_MESSAGE));
+	clearShips();
+}
@@ -0,0 +1,249 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "AttackGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+	typedef sim::ShiftRegisterMatrix::Latch Latch;
+
+	enum {
+		TILES_PER_BYTE = 3,
+		TILE_BITS      = 2,
+	};
+
+	size_t count(const std::vector<Message> & messages, uint8_t command) {
+		size_t n = 0;
+		for (size_t i = 0; i < messages.size(); i++) {
+			if (messages[i].command == command) {
+				n++;
+			}
+		}
+		return n;
+	}
+
+	std::vector<uint8_t> packedBoard(uint8_t type) {
+		std::vector<uint8_t> packed;
+		for (uint8_t tile = 0; tile < ROWS * COLUMNS; tile += TILES_PER_BYTE) {
+			uint8_t byte = 0;
+			for (uint8_t i = 0; i < TILES_PER_BYTE; i++) {
+				byte |= type << (i * TILE_BITS);
+			}
+			packed.push_back(byte);
+		}
+		return packed;
+	}
+
+	void sendBoard(uint8_t row, uint8_t column, uint8_t rows, uint8_t columns,
+			uint8_t type) {
+		std::vector<uint8_t> data = { row, column, rows, columns };
+		const std::vector<uint8_t> packed = packedBoard(type);
+		data.insert(data.end(), packed.begin(),
+			packed.begin() + (rows * columns + TILES_PER_BYTE - 1) / TILES_PER_BYTE);
+		host.sendSysex(TILE_TYPE_BULK_MESSAGE, data);
+	}
+}
+
+TEST(reportsVersionAndFirmwareOnStartup) {
+	boot();
+	EXPECT_EQ(1u, count(startupMessages, REPORT_VERSION));
+	EXPECT_EQ(1u, count(startupMessages, REPORT_FIRMWARE));
+}
+
+TEST(repliesToGridConfigQuery) {
+	boot();
+	host.sendSysex(GRID_CONFIG_MESSAGE, { GRID_CONFIG_QUERY });
+	runFrames(2);
+	const std::vector<Message> replies = host.receiveSysex(GRID_CONFIG_MESSAGE);
+	EXPECT_EQ(1u, replies.size());
+	if (replies.size() == 1) {
+		const std::vector<uint8_t> expected = {
+			GRID_CONFIG_REPLY,
+			FEATURE_TILE_CHANGE_FRAME | FEATURE_TILE_TYPE_ACK,
+			0x00
+		};
+		EXPECT_TRUE(replies[0].data == expected);
+	}
+}
+
+TEST(showsTileTypeWithoutEcho) {
+	boot();
+	host.sendSysex(TILE_TYPE_MESSAGE, { HIT, 3, 4 });
+	runFrames(2);
+	EXPECT_EQ(0u, count(host.receive(), STRING_DATA));
+	matrix.clearIntegration();
+	runFrames(5);
+	const std::string shown = matrix.render();
+	printf("%s", shown.c_str());
+	// Rows are rendered top down, one line per row.
+	EXPECT_EQ('Y', shown[3 * (COLUMNS + 1) + 4]);
+	EXPECT_EQ('C', shown[3 * (COLUMNS + 1) + 5]);
+	host.sendSysex(TILE_TYPE_MESSAGE, { NONE, 3, 4 });
+	runFrames(2);
+}
+
+TEST(rejectsTileTypeOutsideTheGrid) {
+	boot();
+	matrix.clearIntegration();
+	runFrames(5);
+	const std::string before = matrix.render();
+	const std::vector<std::vector<uint8_t> > invalid = {
+		{ HIT, ROWS, 0 },
+		{ HIT, 0, COLUMNS },
+		{ 0x7F, 1, 1 },
+	};
+	for (size_t i = 0; i < invalid.size(); i++) {
+		host.sendSysex(TILE_TYPE_MESSAGE, invalid[i]);
+		runFrames(2);
+		EXPECT_EQ(1u, count(host.receive(), STRING_DATA));
+	}
+	matrix.clearIntegration();
+	runFrames(5);
+	EXPECT_TRUE(matrix.render() == before);
+}
+
+TEST(acknowledgesTileTypesWhenEnabled) {
+	boot();
+	setFeatures(FEATURE_TILE_TYPE_ACK);
+	host.sendSysex(TILE_TYPE_MESSAGE, { WATER, 1, 1 });
+	host.sendSysex(TILE_TYPE_MESSAGE, { NONE, 1, 1 });
+	runFrames(2);
+	const std::vector<Message> acks = host.receiveSysex(TILE_TYPE_ACK_MESSAGE);
+	EXPECT_EQ(2u, acks.size());
+	for (size_t i = 0; i < acks.size(); i++) {
+		const std::vector<uint8_t> expected = {
+			static_cast<uint8_t>(i), TILE_TYPE_MESSAGE
+		};
+		EXPECT_TRUE(acks[i].data == expected);
+	}
+	setFeatures(0x00);
+}
+
+TEST(rejectsBulkUploadOutsideTheGrid) {
+	boot();
+	sendBoard(4, 4, ROWS, COLUMNS, WATER);
+	runFrames(2);
+	EXPECT_EQ(1u, count(host.receive(), STRING_DATA));
+}
+
+TEST(dropsMessageLongerThanInputBuffer) {
+	boot();
+	// Beyond the 64 bytes of the default MAX_DATA_BYTES.
+	host.sendSysex(TILE_TYPE_MESSAGE, std::vector<uint8_t>(100, WATER));
+	runFrames(4);
+	const std::vector<Message> replies = host.receive();
+	EXPECT_EQ(1u, replies.size());
+	EXPECT_EQ(1u, count(replies, STRING_DATA));
+	// The parser is ready for the next message.
+	host.sendSysex(GRID_CONFIG_MESSAGE, { GRID_CONFIG_QUERY });
+	runFrames(2);
+	EXPECT_EQ(1u, host.receiveSysex(GRID_CONFIG_MESSAGE).size());
+}
+
+TEST(showsBulkUploadAtFrameBoundary) {
+	boot();
+	matrix.clearLatches();
+	runFrames(2);
+	sendBoard(0, 0, ROWS, COLUMNS, WATER);
+	runFrames(10);
+	// Every complete frame shows either the old cyan or the new blue board.
+	const std::vector<Latch> & latches = matrix.latches();
+	uint32_t oldFrames = 0;
+	uint32_t newFrames = 0;
+	uint32_t tornFrames = 0;
+	uint8_t green = 0;
+	uint8_t columns = 0;
+	bool hasGreen = false;
+	bool hasNoGreen = false;
+	for (size_t i = 0; i < latches.size(); i++) {
+		if ((latches[i].columns == 0x01) && (columns == 0xFF)) {
+			if (hasGreen && hasNoGreen) {
+				tornFrames++;
+			} else if (hasGreen) {
+				oldFrames++;
+			} else {
+				newFrames++;
+			}
+		}
+		if ((latches[i].columns == 0x01) &&
+				((i == 0) || (latches[i - 1].columns != 0x01))) {
+			columns = 0;
+			hasGreen = false;
+			hasNoGreen = false;
+		}
+		columns |= latches[i].columns;
+		green = latches[i].rows[sim::ShiftRegisterMatrix::GREEN];
+		// Only the most significant bit of each column is lit for sure.
+		if ((i + 1 == latches.size()) ||
+				(latches[i + 1].columns != latches[i].columns)) {
+			if (green == 0xFF) {
+				hasGreen = true;
+			} else if (green == 0x00) {
+				hasNoGreen = true;
+			} else {
+				tornFrames++;
+			}
+		}
+	}
+	printf("  %u old, %u new, %u torn frames\n", oldFrames, newFrames,
+		tornFrames);
+	EXPECT_TRUE(oldFrames > 0);
+	EXPECT_TRUE(newFrames > 0);
+	EXPECT_EQ(0u, tornFrames);
+	sendBoard(0, 0, ROWS, COLUMNS, NONE);
+	runFrames(2);
+	host.receive();
+}
@@ -0,0 +1,308 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "AttackGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	enum {
+		SECOND_MICROS     = 1000000,
+		COLUMN_REGISTERS  = 4,
+		MCP3008_FRAME10_BYTES = 3,
+		BCM_BASE_MICROS   = FRAME_MICROS / COLUMNS / ((1 << BITS_PER_COLOR) - 1),
+		LATCHES_PER_COLUMN = BITS_PER_COLOR,
+	};
+
+	// Phases of the scan profile.
+	enum Phase {
+		PHASE_WRITE_COLUMN,
+		PHASE_CHARGE_WAIT,
+		PHASE_ADC_SWEEP,
+		PHASE_COMPARATOR,
+		PHASE_FIRMATA_PARSE,
+		MAX_PHASES
+	};
+
+	enum {
+		PROFILE_COUNT,
+		PROFILE_MIN,
+		PROFILE_MAX,
+		PROFILE_AVERAGE,
+		PROFILE_HISTOGRAM,
+		HISTOGRAM_BUCKETS     = 8,
+		PROFILE_VALUES        = PROFILE_HISTOGRAM + HISTOGRAM_BUCKETS,
+		PROFILE_BYTES         = PROFILE_VALUES * 2,
+		ENCODED_PROFILE_BYTES = (PROFILE_BYTES * 8 + 6) / 7,
+	};
+
+	typedef sim::ShiftRegisterMatrix::Latch Latch;
+
+	/// <summary>
+	/// Index of the first latch of each complete frame.
+	/// </summary>
+	std::vector<size_t> frameStarts(const std::vector<Latch> & latches) {
+		std::vector<size_t> starts;
+		for (size_t i = 0; i < latches.size(); i++) {
+			const bool isFirstColumn = (latches[i].columns == 0x01);
+			const bool wasFirstColumn = (i > 0) && (latches[i - 1].columns == 0x01);
+			if (isFirstColumn && !wasFirstColumn) {
+				starts.push_back(i);
+			}
+		}
+		return starts;
+	}
+
+	/// <summary>
+	/// Query the profile of each phase. The replies are bigger than the
+	/// backlog of the serial port, so one is queried at a time. Returns the
+	/// 16-bit values of each phase, empty if it has not been reported.
+	/// </summary>
+	std::vector<std::vector<uint16_t> > queryProfile(uint8_t flags) {
+		std::vector<std::vector<uint16_t> > profile(MAX_PHASES);
+		for (uint8_t phase = 0; phase < MAX_PHASES; phase++) {
+			host.sendSysex(PROFILE_MESSAGE, { phase, flags });
+			runFrames(1);
+			const std::vector<sim::FirmataHost::Message> replies =
+				host.receiveSysex(PROFILE_MESSAGE);
+			if ((replies.size() != 1) ||
+					(replies[0].data.size() != 1 + ENCODED_PROFILE_BYTES) ||
+					(replies[0].data[0] != phase)) {
+				continue;
+			}
+			const std::vector<uint8_t> bytes = sim::FirmataHost::decode7Bit(
+				&replies[0].data[1], ENCODED_PROFILE_BYTES, PROFILE_BYTES);
+			for (size_t i = 0; i < PROFILE_VALUES; i++) {
+				profile[phase].push_back(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+			}
+		}
+		return profile;
+	}
+
+	void runOneSecond() {
+		boot();
+		matrix.clearLatches();
+		adc.clearConversions();
+		sim::resetStats();
+		runFrames(FPS);
+	}
+}
+
+TEST(refreshesAtFrameRate) {
+	runOneSecond();
+	const std::vector<size_t> starts = frameStarts(matrix.latches());
+	printf("  %u frames in 1 s\n", static_cast<unsigned>(starts.size()));
+	EXPECT_NEAR(FPS, starts.size(), 1);
+}
+
+TEST(startsScanAtFirstColumn) {
+	boot();
+	EXPECT_TRUE(startupLatches.size() > COLUMNS * LATCHES_PER_COLUMN);
+	if (startupLatches.size() > COLUMNS * LATCHES_PER_COLUMN) {
+		for (size_t i = 0; i < COLUMNS * LATCHES_PER_COLUMN; i++) {
+			const uint8_t column = i / LATCHES_PER_COLUMN;
+			EXPECT_EQ(1 << column, startupLatches[i].columns);
+		}
+	}
+}
+
+TEST(latchesEachColumnOncePerBit) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const std::vector<size_t> starts = frameStarts(latches);
+	EXPECT_TRUE(starts.size() > 1);
+	for (size_t f = 0; f + 1 < starts.size(); f++) {
+		EXPECT_EQ(COLUMNS * LATCHES_PER_COLUMN, starts[f + 1] - starts[f]);
+		for (size_t i = starts[f]; i < starts[f + 1]; i++) {
+			const uint8_t column = (i - starts[f]) / LATCHES_PER_COLUMN;
+			EXPECT_EQ(1 << column, latches[i].columns);
+		}
+	}
+}
+
+TEST(bitIntervalsAreBinaryWeighted) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const std::vector<size_t> starts = frameStarts(latches);
+	uint32_t maxErrorNanos = 0;
+	for (size_t i = starts.front(); i + 1 < latches.size(); i++) {
+		const uint8_t bit = (i - starts.front()) % LATCHES_PER_COLUMN;
+		const int64_t expectedNanos = (BCM_BASE_MICROS << bit) * 1000LL;
+		const int64_t intervalNanos = latches[i + 1].nanos - latches[i].nanos;
+		const uint32_t errorNanos = static_cast<uint32_t>(
+			std::abs(intervalNanos - expectedNanos));
+		maxErrorNanos = std::max(maxErrorNanos, errorNanos);
+	}
+	printf("  base %u us, max error %u ns\n",
+		static_cast<unsigned>(BCM_BASE_MICROS),
+		static_cast<unsigned>(maxErrorNanos));
+	EXPECT_TRUE(maxErrorNanos < 1000);
+}
+
+TEST(interruptsNeverOverrun) {
+	runOneSecond();
+	const sim::InterruptStats & stats = sim::interruptStats();
+	printf("  %u interrupts, %.1f %% busy, longest %u ns\n",
+		static_cast<unsigned>(stats.count),
+		100.0 * stats.busyNanos / (SECOND_MICROS * 1000.0),
+		static_cast<unsigned>(stats.maxNanos));
+	EXPECT_EQ(0u, stats.overruns);
+	EXPECT_NEAR(FPS * COLUMNS * LATCHES_PER_COLUMN, stats.count,
+		COLUMNS * LATCHES_PER_COLUMN);
+	// The longest interrupt senses the photodiodes and must end before the
+	// shortest bit interval would have been over.
+	EXPECT_TRUE(stats.maxNanos < BCM_BASE_MICROS * 1000u * (1 << (BITS_PER_COLOR - 1)));
+	EXPECT_TRUE(stats.busyNanos < SECOND_MICROS * 1000ULL / 5);
+}
+
+TEST(sensesEachColumnDuringMostSignificantBit) {
+	runOneSecond();
+	const std::vector<Latch> & latches = matrix.latches();
+	const std::vector<sim::Mcp3008::Conversion> & conversions = adc.conversions();
+	EXPECT_NEAR(FPS * COLUMNS * ROWS, conversions.size(), COLUMNS * ROWS);
+	// The column being scanned when the recording began is not complete.
+	const std::vector<size_t> starts = frameStarts(latches);
+	EXPECT_TRUE(!starts.empty());
+	if (starts.empty()) {
+		return;
+	}
+	size_t latch = starts.front();
+	uint32_t misplaced = 0;
+	for (size_t i = 0; i < conversions.size(); i++) {
+		if (conversions[i].nanos < latches[latch].nanos) {
+			continue;
+		}
+		while ((latch + 1 < latches.size()) &&
+				(latches[latch + 1].nanos <= conversions[i].nanos)) {
+			latch++;
+		}
+		// The most significant bit is the last latch of a column.
+		const bool isMostSignificantBit = (latch >= LATCHES_PER_COLUMN - 1) &&
+			(latches[latch - (LATCHES_PER_COLUMN - 1)].columns
+				== latches[latch].columns) &&
+			((latch + 1 == latches.size()) ||
+				(latches[latch + 1].columns != latches[latch].columns));
+		if (!isMostSignificantBit) {
+			misplaced++;
+		}
+	}
+	EXPECT_EQ(0u, misplaced);
+}
+
+TEST(profilesEachPhaseOfTheScan) {
+	boot();
+	queryProfile(PROFILE_RESET);
+	runFrames(FPS);
+	const std::vector<std::vector<uint16_t> > profile = queryProfile(0x00);
+	static const char * const names[MAX_PHASES] = {
+		"write column", "charge wait", "ADC sweep", "comparator", "parse"
+	};
+	for (uint8_t phase = 0; phase < MAX_PHASES; phase++) {
+		EXPECT_EQ(static_cast<size_t>(PROFILE_VALUES), profile[phase].size());
+		if (profile[phase].size() != PROFILE_VALUES) {
+			continue;
+		}
+		const std::vector<uint16_t> & p = profile[phase];
+		printf("  %-12s %5u x %4u us avg, %4u..%4u us\n", names[phase],
+			p[PROFILE_COUNT], p[PROFILE_AVERAGE], p[PROFILE_MIN],
+			p[PROFILE_MAX]);
+		EXPECT_TRUE(p[PROFILE_COUNT] > 0);
+		EXPECT_TRUE(p[PROFILE_MIN] <= p[PROFILE_AVERAGE]);
+		EXPECT_TRUE(p[PROFILE_AVERAGE] <= p[PROFILE_MAX]);
+		uint32_t histogramCount = 0;
+		for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			histogramCount += p[PROFILE_HISTOGRAM + i];
+		}
+		EXPECT_EQ(p[PROFILE_COUNT], histogramCount);
+	}
+	if (profile[PHASE_CHARGE_WAIT].size() == PROFILE_VALUES) {
+		// Counted over the second and the frames it took to query.
+		EXPECT_NEAR(FPS * COLUMNS * LATCHES_PER_COLUMN,
+			profile[PHASE_WRITE_COLUMN][PROFILE_COUNT],
+			6 * COLUMNS * LATCHES_PER_COLUMN);
+		EXPECT_NEAR(FPS * COLUMNS,
+			profile[PHASE_ADC_SWEEP][PROFILE_COUNT], 6 * COLUMNS);
+		// The LEDs charge during all but the most significant bit.
+		EXPECT_NEAR(BCM_BASE_MICROS * ((1 << (BITS_PER_COLOR - 1)) - 1),
+			profile[PHASE_CHARGE_WAIT][PROFILE_AVERAGE], BCM_BASE_MICROS);
+	}
+}
+
+TEST(spiPhasesAreBoundByTheClock) {
+	boot();
+	queryProfile(PROFILE_RESET);
+	runFrames(FPS / 10);
+	const std::vector<std::vector<uint16_t> > profile = queryProfile(0x00);
+	EXPECT_EQ(static_cast<size_t>(PROFILE_VALUES),
+		profile[PHASE_WRITE_COLUMN].size());
+	EXPECT_EQ(static_cast<size_t>(PROFILE_VALUES),
+		profile[PHASE_ADC_SWEEP].size());
+	if ((profile[PHASE_WRITE_COLUMN].size() != PROFILE_VALUES) ||
+			(profile[PHASE_ADC_SWEEP].size() != PROFILE_VALUES)) {
+		return;
+	}
+	// Time of shifting the bytes alone, the rest is spent by the CPU.
+	const uint32_t writeColumnShiftMicros =
+		COLUMN_REGISTERS * 8 * SECOND_MICROS / F_SCK_LED_MATRIX;
+	const uint32_t adcSweepShiftMicros =
+		ROWS * MCP3008_FRAME10_BYTES * 8 * SECOND_MICROS / F_SCK_PHOTODIODE_ARRAY;
+	const uint16_t writeColumnMicros = profile[PHASE_WRITE_COLUMN][PROFILE_MAX];
+	const uint16_t adcSweepMicros = profile[PHASE_ADC_SWEEP][PROFILE_MAX];
+	printf("  write column %u us, %u us shifting\n",
+		writeColumnMicros, static_cast<unsigned>(writeColumnShiftMicros));
+	printf("  ADC sweep    %u us, %u us shifting\n",
+		adcSweepMicros, static_cast<unsigned>(adcSweepShiftMicros));
+	EXPECT_TRUE(writeColumnMicros <= writeColumnShiftMicros + 2);
+	EXPECT_TRUE(adcSweepMicros <= adcSweepShiftMicros + 8);
+}
@@ -0,0 +1,312 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host test of the FirmataScheduler which the sketches can use for timed
+ * animations.
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "FirmataHost.h"
+#include "Simulator.h"
+#include "Test.h"
+
+#include <ConfigurableFirmata.h>
+#include <FirmataExt.h>
+#include <FirmataScheduler.h>
+
+namespace {
+
+	enum Scheduler {
+		CREATE_TASK     = 0,
+		DELETE_TASK     = 1,
+		ADD_TO_TASK     = 2,
+		DELAY_TASK      = 3,
+		SCHEDULE_TASK   = 4,
+		QUERY_TASK      = 6,
+		RESET_TASKS     = 7,
+		ERROR_REPLY     = 8,
+		QUERY_REPLY     = 10,
+		// Bytes of a task message showing one character.
+		MARK_BYTES      = 5,
+	};
+
+	FirmataExt firmataExt;
+	FirmataScheduler scheduler;
+	sim::FirmataHost host;
+
+	struct Mark {
+		unsigned long millis;
+		char mark;
+	};
+
+	std::vector<Mark> marks;
+
+	void onString(char * text) {
+		marks.push_back({ millis(), text[0] });
+	}
+
+	void loopFirmware() {
+		while (Firmata.available()) {
+			Firmata.processInput();
+		}
+		scheduler.runTasks();
+	}
+
+	void runMillis(uint32_t ms) {
+		sim::run(loopFirmware, ms * 1000);
+	}
+
+	void boot() {
+		static bool isBooted = false;
+		if (!isBooted) {
+			isBooted = true;
+			Firmata.begin(57600);
+			Firmata.attach(STRING_DATA, onString);
+			firmataExt.addFeature(scheduler);
+			runMillis(10);
+		}
+		host.sendSysex(SCHEDULER_DATA, { RESET_TASKS });
+		runMillis(10);
+		host.receive();
+		marks.clear();
+	}
+
+	std::vector<uint8_t> encodeLong(long value) {
+		std::vector<uint8_t> bytes;
+		for (uint8_t i = 0; i < 4; i++) {
+			bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+		return sim::FirmataHost::encode7Bit(bytes);
+	}
+
+	std::vector<uint8_t> mark(char c) {
+		return { START_SYSEX, STRING_DATA, static_cast<uint8_t>(c), 0, END_SYSEX };
+	}
+
+	std::vector<uint8_t> delayBy(long ms) {
+		std::vector<uint8_t> message = { START_SYSEX, SCHEDULER_DATA, DELAY_TASK };
+		const std::vector<uint8_t> encoded = encodeLong(ms);
+		message.insert(message.end(), encoded.begin(), encoded.end());
+		message.push_back(END_SYSEX);
+		return message;
+	}
+
+	std::vector<uint8_t> scheduleBy(uint8_t id, long ms) {
+		std::vector<uint8_t> message = { START_SYSEX, SCHEDULER_DATA, SCHEDULE_TASK, id };
+		const std::vector<uint8_t> encoded = encodeLong(ms);
+		message.insert(message.end(), encoded.begin(), encoded.end());
+		message.push_back(END_SYSEX);
+		return message;
+	}
+
+	void createTask(uint8_t id, const std::vector<uint8_t> & messages) {
+		const uint16_t length = static_cast<uint16_t>(messages.size());
+		host.sendSysex(SCHEDULER_DATA, {
+			CREATE_TASK, id,
+			static_cast<uint8_t>(length & 0x7F), static_cast<uint8_t>(length >> 7)
+		});
+		std::vector<uint8_t> add = { ADD_TO_TASK, id };
+		const std::vector<uint8_t> encoded = sim::FirmataHost::encode7Bit(messages);
+		add.insert(add.end(), encoded.begin(), encoded.end());
+		host.sendSysex(SCHEDULER_DATA, add);
+	}
+
+	void scheduleTask(uint8_t id, long ms) {
+		std::vector<uint8_t> data = { SCHEDULE_TASK, id };
+		const std::vector<uint8_t> encoded = encodeLong(ms);
+		data.insert(data.end(), encoded.begin(), encoded.end());
+		host.sendSysex(SCHEDULER_DATA, data);
+	}
+
+	std::vector<uint8_t> concat(const std::vector<uint8_t> & a,
+			const std::vector<uint8_t> & b) {
+		std::vector<uint8_t> c = a;
+		c.insert(c.end(), b.begin(), b.end());
+		return c;
+	}
+
+	std::string marksText() {
+		std::string text;
+		for (size_t i = 0; i < marks.size(); i++) {
+			text += marks[i].mark;
+		}
+		return text;
+	}
+}
+
+TEST(runsTaskAtItsTime) {
+	boot();
+	createTask(1, mark('A'));
+	runMillis(5);
+	const unsigned long start = millis();
+	scheduleTask(1, 50);
+	runMillis(40);
+	EXPECT_EQ(0u, marks.size());
+	runMillis(20);
+	EXPECT_EQ(1u, marks.size());
+	if (marks.size() == 1) {
+		EXPECT_NEAR(50, marks[0].millis - start, 3);
+	}
+}
+
+TEST(runsDueTasksInOrderOfTime) {
+	boot();
+	createTask(1, mark('A'));
+	createTask(2, mark('B'));
+	createTask(3, mark('C'));
+	scheduleTask(1, 30);
+	scheduleTask(2, 10);
+	scheduleTask(3, 20);
+	runMillis(50);
+	EXPECT_TRUE(marksText() == "BCA");
+}
+
+TEST(repeatsTaskThatDelaysItself) {
+	boot();
+	createTask(1, concat(mark('R'), delayBy(100)));
+	scheduleTask(1, 0);
+	runMillis(1005);
+	EXPECT_EQ(10u, marks.size());
+	for (size_t i = 1; i < marks.size(); i++) {
+		EXPECT_NEAR(100, marks[i].millis - marks[i - 1].millis, 1);
+	}
+}
+
+TEST(runsTaskInThePastOncePerCall) {
+	boot();
+	createTask(1, concat(mark('P'), scheduleBy(1, -50)));
+	scheduleTask(1, 0);
+	runMillis(10);
+	EXPECT_TRUE(marks.size() > 0);
+	marks.clear();
+	scheduler.runTasks();
+	EXPECT_EQ(1u, marks.size());
+	// Due again at the time of the first call, so once a millisecond passed.
+	sim::skip(1000000ULL);
+	scheduler.runTasks();
+	EXPECT_EQ(2u, marks.size());
+}
+
+TEST(handlesWrapAroundOfMillis) {
+	boot();
+	// Get 40 ms close to the wrap around of the 32 bit millis().
+	const uint64_t wrapNanos = (1ULL << 32) * 1000000ULL;
+	sim::skip(wrapNanos - (sim::nanos() % wrapNanos) - 40 * 1000000ULL);
+	createTask(1, mark('W'));
+	createTask(2, concat(mark('R'), delayBy(20)));
+	runMillis(5);
+	scheduleTask(1, 60);
+	scheduleTask(2, 0);
+	runMillis(50);
+	// The task due after the wrap around must not run early.
+	EXPECT_EQ(std::string::npos, marksText().find('W'));
+	runMillis(20);
+	const std::string text = marksText();
+	EXPECT_EQ(1, std::count(text.begin(), text.end(), 'W'));
+	EXPECT_NEAR(4, std::count(text.begin(), text.end(), 'R'), 1);
+}
+
+TEST(reusesArenaOfDeletedTasks) {
+	boot();
+	const uint8_t tasks = FIRMATA_SCHEDULER_ARENA_SIZE / MARK_BYTES;
+	const uint8_t maxTasks = (tasks < FIRMATA_SCHEDULER_MAX_TASKS) ?
+		tasks : FIRMATA_SCHEDULER_MAX_TASKS;
+	for (uint8_t id = 0; id < maxTasks; id++) {
+		createTask(id, mark('a' + id));
+		runMillis(5);
+	}
+	// Both the creation and the loading of the task are rejected.
+	createTask(maxTasks, mark('x'));
+	runMillis(5);
+	EXPECT_EQ(2u, host.receiveSysex(SCHEDULER_DATA).size());
+	// Free a task in the middle, the others must keep their messages.
+	host.sendSysex(SCHEDULER_DATA, { DELETE_TASK, 1 });
+	createTask(maxTasks, mark('x'));
+	runMillis(5);
+	EXPECT_EQ(0u, host.receiveSysex(SCHEDULER_DATA).size());
+	// Tasks share the parser with the input, so none may run before all
+	// messages have been received.
+	for (uint8_t id = 0; id <= maxTasks; id++) {
+		scheduleTask(id, 50 + id);
+		runMillis(2);
+	}
+	runMillis(100);
+	std::string expected;
+	for (uint8_t id = 0; id < maxTasks; id++) {
+		if (id != 1) {
+			expected += static_cast<char>('a' + id);
+		}
+	}
+	expected += 'x';
+	EXPECT_TRUE(marksText() == expected);
+}
+
+TEST(reportsQueriedTask) {
+	boot();
+	createTask(5, mark('Q'));
+	host.sendSysex(SCHEDULER_DATA, { QUERY_TASK, 5 });
+	runMillis(10);
+	const std::vector<sim::FirmataHost::Message> replies =
+		host.receiveSysex(SCHEDULER_DATA);
+	EXPECT_EQ(1u, replies.size());
+	if (replies.size() == 1) {
+		const std::vector<uint8_t> & data = replies[0].data;
+		EXPECT_EQ(QUERY_REPLY, data[0]);
+		EXPECT_EQ(5, data[1]);
+		const std::vector<uint8_t> fields = sim::FirmataHost::decode7Bit(
+			data.data() + 2, data.size() - 2, 8 + MARK_BYTES);
+		EXPECT_EQ(MARK_BYTES, fields[4]); // Length.
+		EXPECT_EQ(MARK_BYTES, fields[6]); // Position after loading.
+		EXPECT_EQ('Q', fields[8 + 2]);
+	}
+}
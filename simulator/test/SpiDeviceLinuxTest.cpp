@@ -0,0 +1,319 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <type_traits>
+#include <vector>
+
+// Enough segments for all channels of a MCP3008, but not for more.
+#define SPI_DEVICE_MAX_SEGMENTS 8
+
+#include <SpiDevice.h>
+
+#include "Test.h"
+
+// The grid drivers on the Linux backend, with the Arduino core of the
+// simulator for its helpers such as min(). It comes last, as its macros
+// would clash with the C++ library.
+#include "LaserPhotoresistorArray.h"
+#include "RgbLedMatrix.h"
+#include "RgbLedPhotodiodeArray.h"
+
+namespace {
+
+	enum {
+		MCP3008_CHANNELS       = 8,
+		F_SCK                  = 2000000,
+	};
+
+	/// <summary>
+	/// MCP3008 that converts each channel to a value derived from its index.
+	/// It expects one conversion per frame, like on the PCB, either with the
+	/// 8-bit framing or the byte aligned 10-bit framing.
+	/// </summary>
+	class Mcp3008 : public SpiDeviceLoopback {
+
+	protected:
+		void transfer(const uint8_t * tx, uint8_t * rx, uint32_t length) {
+			// The buffers are the same, like those of the driver.
+			if ((length == 2) && ((tx[0] & 0x60) == 0x60)) {
+				// Start and single ended bits, the second byte is B9..B2.
+				const uint16_t reading = channelReading((tx[0] >> 2) & 0x07);
+				rx[0] = 0x00;
+				rx[1] = reading >> 2;
+			} else if ((length == 3) && (tx[0] == 0x01) && (tx[1] & 0x80)) {
+				// Start byte and single ended bit, followed by B9..B0.
+				const uint16_t reading = channelReading((tx[1] >> 4) & 0x07);
+				rx[0] = 0x00;
+				rx[1] = (reading >> 8) & 0x03;
+				rx[2] = reading & 0xFF;
+			} else {
+				memset(rx, 0xFF, length);
+			}
+		}
+
+	public:
+		static uint16_t channelReading(uint8_t channel) {
+			return 0x080 * channel + 0x011;
+		}
+	};
+
+	/// <summary>
+	/// Loopback that remembers the bytes on the wire.
+	/// </summary>
+	class WireTap : public SpiDeviceLoopback {
+
+	protected:
+		void transfer(const uint8_t * tx, uint8_t * rx, uint32_t length) {
+			onWire.insert(onWire.end(), tx, tx + length);
+			SpiDeviceLoopback::transfer(tx, rx, length);
+		}
+
+	public:
+		std::vector<uint8_t> onWire;
+	};
+
+	/// <summary>
+	/// Reference that reverses the bits of a byte one by one.
+	/// </summary>
+	uint8_t reverseBits(uint8_t byte) {
+		uint8_t reversed = 0;
+		for (int bit = 0; bit < 8; bit++) {
+			reversed = (reversed << 1) | ((byte >> bit) & 0x01);
+		}
+		return reversed;
+	}
+}
+
+TEST(configuresDeviceOnMaster) {
+	SpiDeviceLoopback loopback;
+	SpiDevicePort::use(&loopback);
+	SpiDevice<0, F_SCK, SpiBitOrderMsbFirst, SpiMode3>::master();
+	EXPECT_EQ(SPI_MODE_3, loopback.mode);
+	EXPECT_EQ(8, loopback.bitsPerWord);
+	EXPECT_EQ(static_cast<uint32_t>(F_SCK), loopback.speedHz);
+	SpiDevicePort::use(NULL);
+}
+
+TEST(readsAllPhotodiodesWithOneIoctl) {
+	typedef RgbLedPhotodiodeArray<SpiDevice<0, F_SCK> > Photodiodes;
+	Mcp3008 mcp3008;
+	SpiDevicePort::use(&mcp3008);
+	Photodiodes::begin();
+	mcp3008.messages = 0;
+	mcp3008.frames = 0;
+	uint16_t diodes[MCP3008_CHANNELS];
+	EXPECT_EQ(MCP3008_CHANNELS, Photodiodes::read(diodes, MCP3008_CHANNELS));
+	printf("  %u frames in %u ioctl\n",
+		static_cast<unsigned>(mcp3008.frames),
+		static_cast<unsigned>(mcp3008.messages));
+	EXPECT_EQ(1u, mcp3008.messages);
+	// Slave select is toggled between the conversions.
+	EXPECT_EQ(static_cast<uint32_t>(MCP3008_CHANNELS), mcp3008.frames);
+	for (uint8_t i = 0; i < MCP3008_CHANNELS; i++) {
+		EXPECT_EQ(Mcp3008::channelReading(i), diodes[i]);
+	}
+	SpiDevicePort::use(NULL);
+}
+
+TEST(readsPhotoresistorsAtBothResolutions) {
+	typedef LaserPhotoresistorArray<SpiDevice<0, F_SCK> > Photoresistors;
+	Mcp3008 mcp3008;
+	SpiDevicePort::use(&mcp3008);
+	Photoresistors::begin();
+	mcp3008.messages = 0;
+	// Fewer channels than the ADC has.
+	uint8_t bytes[MCP3008_CHANNELS - 2];
+	EXPECT_EQ(sizeof(bytes), Photoresistors::read(bytes, sizeof(bytes)));
+	uint16_t words[MCP3008_CHANNELS + 2];
+	EXPECT_EQ(MCP3008_CHANNELS, Photoresistors::read(words, sizeof(words) / 2));
+	EXPECT_EQ(2u, mcp3008.messages);
+	for (uint8_t i = 0; i < MCP3008_CHANNELS; i++) {
+		if (i < sizeof(bytes)) {
+			EXPECT_EQ(Mcp3008::channelReading(i) >> 2, bytes[i]);
+		}
+		EXPECT_EQ(Mcp3008::channelReading(i), words[i]);
+	}
+	// Single channels within a transaction, like the interleaved sweep.
+	Photoresistors::beginTransaction();
+	EXPECT_EQ(Mcp3008::channelReading(5), Photoresistors::readChannel(5));
+	Photoresistors::endTransaction();
+	SpiDevicePort::use(NULL);
+}
+
+TEST(splitsFramesBeyondMaxSegments) {
+	typedef SpiDevice<1, F_SCK> Matrix;
+	SpiDeviceLoopback loopback;
+	SpiDevicePort::use(&loopback);
+	Matrix::master();
+	enum { FRAMES = 2 * SPI_DEVICE_MAX_SEGMENTS + 1, FRAME_BYTES = 4 };
+	uint8_t data[FRAMES * FRAME_BYTES];
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+	EXPECT_TRUE(Matrix::transferFrames(data, FRAME_BYTES, FRAMES));
+	EXPECT_EQ(3u, loopback.messages);
+	EXPECT_EQ(static_cast<uint32_t>(FRAMES), loopback.frames);
+	EXPECT_EQ(sizeof(data), loopback.bytes);
+	bool isEchoed = true;
+	for (size_t i = 0; i < sizeof(data); i++) {
+		isEchoed &= (data[i] == i);
+	}
+	EXPECT_TRUE(isEchoed);
+	SpiDevicePort::use(NULL);
+}
+
+TEST(splitsFramesBeyondMaxMessageBytes) {
+	typedef SpiDevice<1, F_SCK> Display;
+	SpiDeviceLoopback loopback;
+	SpiDevicePort::use(&loopback);
+	Display::master();
+	// Fewer frames than segments, but more bytes than spidev takes at once.
+	enum { FRAMES = 5, FRAME_BYTES = 1500 };
+	static uint8_t data[FRAMES * FRAME_BYTES];
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+	EXPECT_TRUE(Display::transferFrames(data, FRAME_BYTES, FRAMES));
+	// Two frames of 1500 bytes fit into 4096 bytes.
+	EXPECT_EQ(3u, loopback.messages);
+	EXPECT_EQ(static_cast<uint32_t>(FRAMES), loopback.frames);
+	EXPECT_EQ(sizeof(data), loopback.bytes);
+	bool isEchoed = true;
+	for (size_t i = 0; i < sizeof(data); i++) {
+		isEchoed &= (data[i] == static_cast<uint8_t>(i));
+	}
+	EXPECT_TRUE(isEchoed);
+	// A single frame beyond it can not be split.
+	EXPECT_TRUE(!Display::transferFrames(
+		data, SPI_DEVICE_MAX_MESSAGE_BYTES + 1, 1));
+	EXPECT_TRUE(!Display::transferBulk(data, SPI_DEVICE_MAX_MESSAGE_BYTES + 1));
+	EXPECT_TRUE(!Display::transferFrame(data, SPI_DEVICE_MAX_MESSAGE_BYTES + 1));
+	EXPECT_EQ(3u, loopback.messages);
+	EXPECT_TRUE(Display::transferBulk(data, SPI_DEVICE_MAX_MESSAGE_BYTES));
+	EXPECT_EQ(4u, loopback.messages);
+	SpiDevicePort::use(NULL);
+}
+
+TEST(reversesBitsOnTheWireForLsbFirst) {
+	typedef SpiDevice<0, F_SCK, SpiBitOrderLsbFirst> Device;
+	WireTap wire;
+	SpiDevicePort::use(&wire);
+	Device::master();
+	EXPECT_EQ(0x2C, Device::transferRegister(0x01, 0x2C));
+	EXPECT_EQ(2u, wire.onWire.size());
+	if (wire.onWire.size() == 2) {
+		EXPECT_EQ(0x80, wire.onWire[0]);
+		EXPECT_EQ(0x34, wire.onWire[1]);
+	}
+	SpiDevicePort::use(NULL);
+}
+
+TEST(letsTheControllerShiftLsbFirstIfSupported) {
+	typedef SpiDevice<1, F_SCK, SpiBitOrderLsbFirst> Device;
+	WireTap wire;
+	wire.isLsbFirstSupported = true;
+	SpiDevicePort::use(&wire);
+	Device::master();
+	EXPECT_EQ(SPI_MODE_0 | SPI_LSB_FIRST, wire.mode);
+	EXPECT_EQ(0x2C, Device::transferRegister(0x01, 0x2C));
+	EXPECT_EQ(2u, wire.onWire.size());
+	if (wire.onWire.size() == 2) {
+		EXPECT_EQ(0x01, wire.onWire[0]);
+		EXPECT_EQ(0x2C, wire.onWire[1]);
+	}
+	SpiDevicePort::use(NULL);
+}
+
+TEST(reversesBytesBitByBit) {
+	bool isReversed = true;
+	for (unsigned i = 0; i < 256; i++) {
+		isReversed &= (SpiDevice_reverseByte(i) == reverseBits(i));
+	}
+	EXPECT_TRUE(isReversed);
+	// Whole words and the remaining bytes.
+	uint8_t data[2 * sizeof(uint64_t) + 3];
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = 0x11 * i + 0x01;
+	}
+	SpiDevice_reverseBytes(data, sizeof(data));
+	for (size_t i = 0; i < sizeof(data); i++) {
+		isReversed &= (data[i] == reverseBits(0x11 * i + 0x01));
+	}
+	EXPECT_TRUE(isReversed);
+}
+
+TEST(runsAttackGridDriversOnSpidev) {
+	typedef RgbLedMatrix<SpiDevice<1, 8000000> > Matrix;
+	typedef RgbLedPhotodiodeArray<SpiDevice<0, F_SCK> > Photodiodes;
+	// Both on the spidev controller, so the scan of the attack grid does not
+	// pipeline them.
+	static_assert(std::is_same<Matrix::Bus, Photodiodes::Bus>::value,
+		"Devices of one controller share the bus");
+	WireTap wireTap;
+	SpiDevicePort::use(&wireTap);
+	Matrix::begin();
+	Photodiodes::begin();
+	EXPECT_EQ(1u, wireTap.messages);
+	wireTap.onWire.clear();
+	Matrix::writeColumn(0x01, 0x02, 0x04, 3);
+	EXPECT_EQ(2u, wireTap.messages);
+	const uint8_t column[] = { 0x08, 0xFB, 0xFD, 0xFE };
+	EXPECT_TRUE(wireTap.onWire ==
+		std::vector<uint8_t>(column, column + sizeof(column)));
+	SpiDevicePort::use(NULL);
+}
+
+TEST(failsWithoutDevice) {
+	// No such spidev device in the test environment.
+	typedef SpiDevice<99> Missing;
+	Missing::master();
+	uint8_t data[2] = { 0x12, 0x34 };
+	EXPECT_TRUE(!Missing::transferFrames(data, sizeof(data), 1));
+}
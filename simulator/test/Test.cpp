@@ -0,0 +1,93 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "Test.h"
+
+namespace test {
+
+	struct Entry {
+		const char * name;
+		TestFunction function;
+	};
+
+	static std::vector<Entry> & entries() {
+		static std::vector<Entry> registered;
+		return registered;
+	}
+
+	static int failures = 0;
+
+	Registrar::Registrar(const char * name, TestFunction function) {
+		entries().push_back({ name, function });
+	}
+
+	void fail(const char * file, int line, const std::string & message) {
+		fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+		failures++;
+	}
+}
+
+int main() {
+	int failedTests = 0;
+	for (const test::Entry & entry : test::entries()) {
+		const int failuresBefore = test::failures;
+		entry.function();
+		const bool passed = (test::failures == failuresBefore);
+		printf("[%s] %s\n", passed ? "PASS" : "FAIL", entry.name);
+		if (!passed) {
+			failedTests++;
+		}
+	}
+	printf("%d of %d tests passed.\n",
+		static_cast<int>(test::entries().size()) - failedTests,
+		static_cast<int>(test::entries().size()));
+	return (failedTests == 0) ? 0 : 1;
+}
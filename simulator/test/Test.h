@@ -0,0 +1,109 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <sstream>
+#include <string>
+
+/// <summary>
+/// Minimal test runner. Tests of a file run in order of their definition
+/// and share the state of the simulated firmware.
+/// </summary>
+namespace test {
+
+	typedef void (*TestFunction)();
+
+	struct Registrar {
+		Registrar(const char * name, TestFunction function);
+	};
+
+	void fail(const char * file, int line, const std::string & message);
+
+	template<typename T>
+	std::string toString(const T & value) {
+		std::ostringstream stream;
+		stream << +value;
+		return stream.str();
+	}
+}
+
+#define TEST(name) \
+	static void name(); \
+	static test::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define EXPECT_TRUE(condition) do { \
+		if (!(condition)) { \
+			test::fail(__FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+#define EXPECT_EQ(expected, actual) do { \
+		const auto expectedValue = (expected); \
+		const auto actualValue = (actual); \
+		if (!(expectedValue == actualValue)) { \
+			test::fail(__FILE__, __LINE__, #actual " is " + \
+				test::toString(actualValue) + ", expected " + \
+				test::toString(expectedValue)); \
+		} \
+	} while (0)
+
+#define EXPECT_NEAR(expected, actual, tolerance) do { \
+		const double expectedValue = (expected); \
+		const double actualValue = (actual); \
+		if ((actualValue < expectedValue - (tolerance)) || \
+				(actualValue > expectedValue + (tolerance))) { \
+			test::fail(__FILE__, __LINE__, #actual " is " + \
+				test::toString(actualValue) + ", expected " + \
+				test::toString(expectedValue) + " +/- " #tolerance); \
+		} \
+	} while (0)
+
+#endif // TEST_H
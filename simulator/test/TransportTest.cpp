@@ -0,0 +1,241 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "AttackGridFixture.h"
+#include "Test.h"
+
+using namespace fixture;
+
+namespace {
+
+	typedef sim::FirmataHost::Message Message;
+
+	enum {
+		STATS_BYTES         = 11,
+		BITMAP_BYTES        = 8,
+		ENCODED_BITMAP_BYTES = (BITMAP_BYTES * 8 + 6) / 7,
+		ENCODED_STATS_BYTES = (STATS_BYTES * 8 + 6) / 7,
+	};
+
+	struct StreamStats {
+		uint32_t bytesDropped;
+		uint16_t messagesDropped;
+		uint32_t stallMicros;
+		uint8_t highWaterMark;
+	};
+
+	uint32_t readLittleEndian(const std::vector<uint8_t> & bytes,
+			size_t offset, size_t size) {
+		uint32_t value = 0;
+		for (size_t i = 0; i < size; i++) {
+			value |= static_cast<uint32_t>(bytes[offset + i]) << (8 * i);
+		}
+		return value;
+	}
+
+	bool queryStreamStats(StreamStats & stats, uint8_t flags) {
+		host.sendSysex(STREAM_STATS_MESSAGE, { flags });
+		runFrames(2);
+		const std::vector<Message> replies =
+			host.receiveSysex(STREAM_STATS_MESSAGE);
+		EXPECT_EQ(1u, replies.size());
+		if ((replies.size() != 1) ||
+				(replies[0].data.size() != ENCODED_STATS_BYTES)) {
+			return false;
+		}
+		const std::vector<uint8_t> bytes = sim::FirmataHost::decode7Bit(
+			replies[0].data.data(), ENCODED_STATS_BYTES, STATS_BYTES);
+		stats.bytesDropped = readLittleEndian(bytes, 0, 4);
+		stats.messagesDropped = readLittleEndian(bytes, 4, 2);
+		stats.stallMicros = readLittleEndian(bytes, 6, 4);
+		stats.highWaterMark = readLittleEndian(bytes, 10, 1);
+		return true;
+	}
+
+	void coverAllButSelectedRow() {
+		for (uint8_t row = 1; row < ROWS; row++) {
+			for (uint8_t column = 0; column < COLUMNS; column++) {
+				readings[row][column] = READING_COVERED;
+			}
+		}
+	}
+
+	void uncoverAll() {
+		setAllReadings(READING_LIT);
+		runFrames(3);
+		host.receive();
+	}
+}
+
+TEST(neverBlocksOnBurstOfTileChanges) {
+	boot();
+	StreamStats stats;
+	queryStreamStats(stats, STREAM_STATS_RESET);
+	sim::resetStats();
+	coverAllButSelectedRow();
+	runFrames(10);
+	const std::vector<Message> changes =
+		host.receiveSysex(TILE_CHANGE_MESSAGE);
+	const size_t tiles = (ROWS - 1) * COLUMNS;
+	printf("  %u of %u tile changes sent, loop took at most %u us\n",
+		static_cast<unsigned>(changes.size()), static_cast<unsigned>(tiles),
+		static_cast<unsigned>(sim::loopStats().maxNanos / 1000));
+	EXPECT_EQ(0u, sim::serialStats().txStallNanos);
+	EXPECT_TRUE(sim::loopStats().maxNanos < FRAME_MICROS * 1000u / 4);
+	// The changes wait for room in the serial port instead of being dropped.
+	EXPECT_EQ(tiles, changes.size());
+	if (queryStreamStats(stats, STREAM_STATS_RESET)) {
+		EXPECT_EQ(0u, stats.messagesDropped);
+		EXPECT_EQ(0u, stats.bytesDropped);
+	}
+	// The statistics start over once reported with the reset flag.
+	if (queryStreamStats(stats, 0x00)) {
+		EXPECT_EQ(0u, stats.messagesDropped);
+		EXPECT_EQ(0u, stats.bytesDropped);
+	}
+	uncoverAll();
+}
+
+TEST(keepsRepliesWhileBusy) {
+	boot();
+	StreamStats stats;
+	queryStreamStats(stats, STREAM_STATS_RESET);
+	coverAllButSelectedRow();
+	runFrames(1);
+	// Sent while the serial port is still busy with the tile changes.
+	host.sendSysex(GRID_CONFIG_MESSAGE, { GRID_CONFIG_QUERY });
+	runFrames(10);
+	const std::vector<Message> messages = host.receive();
+	size_t replies = 0;
+	size_t changes = 0;
+	for (size_t i = 0; i < messages.size(); i++) {
+		if (messages[i].command == GRID_CONFIG_MESSAGE) {
+			replies++;
+		} else if (messages[i].command == TILE_CHANGE_MESSAGE) {
+			changes++;
+		}
+	}
+	EXPECT_EQ(1u, replies);
+	EXPECT_EQ(static_cast<size_t>((ROWS - 1) * COLUMNS), changes);
+	if (queryStreamStats(stats, STREAM_STATS_RESET)) {
+		EXPECT_EQ(0u, stats.messagesDropped);
+	}
+	uncoverAll();
+}
+
+TEST(acknowledgesWhileSaturated) {
+	boot();
+	setFeatures(FEATURE_TILE_TYPE_ACK);
+	StreamStats stats;
+	queryStreamStats(stats, STREAM_STATS_RESET);
+	coverAllButSelectedRow();
+	runFrames(1);
+	// Sent while the tile changes saturate the serial port.
+	host.sendSysex(TILE_TYPE_MESSAGE, { WATER, ROWS - 1, COLUMNS - 1 });
+	runFrames(10);
+	const std::vector<Message> acks =
+		host.receiveSysex(TILE_TYPE_ACK_MESSAGE);
+	EXPECT_EQ(1u, acks.size());
+	if (queryStreamStats(stats, STREAM_STATS_RESET)) {
+		EXPECT_EQ(0u, stats.messagesDropped);
+		// The reserved room let it bypass the backlog.
+		EXPECT_EQ(0u, stats.highWaterMark);
+	}
+	host.sendSysex(TILE_TYPE_MESSAGE, { NONE, ROWS - 1, COLUMNS - 1 });
+	setFeatures(0x00);
+	uncoverAll();
+}
+
+TEST(keepsTileChangeFramesWhileBusy) {
+	boot();
+	setFeatures(FEATURE_TILE_CHANGE_FRAME);
+	StreamStats stats;
+	queryStreamStats(stats, STREAM_STATS_RESET);
+	coverAllButSelectedRow();
+	// Keep the serial port busy with replies while the changes are sensed,
+	// more than it can send.
+	const size_t queries = 60;
+	for (size_t i = 0; i < queries; i++) {
+		host.sendSysex(GRID_CONFIG_MESSAGE, { GRID_CONFIG_QUERY });
+		if (i % 3 == 2) {
+			sim::run(loop, 2000);
+		}
+	}
+	runFrames(10);
+	const std::vector<Message> messages = host.receive();
+	std::vector<uint8_t> changed(BITMAP_BYTES, 0x00);
+	size_t frames = 0;
+	size_t replies = 0;
+	for (size_t i = 0; i < messages.size(); i++) {
+		if (messages[i].command == GRID_CONFIG_MESSAGE) {
+			replies++;
+		} else if (messages[i].command == TILE_CHANGE_FRAME_MESSAGE) {
+			const std::vector<uint8_t> bitmap = sim::FirmataHost::decode7Bit(
+				messages[i].data.data(), ENCODED_BITMAP_BYTES, BITMAP_BYTES);
+			for (uint8_t column = 0; column < BITMAP_BYTES; column++) {
+				changed[column] |= bitmap[column];
+			}
+			frames++;
+		}
+	}
+	printf("  %u frames reported the changes, %u of %u replies sent\n",
+		static_cast<unsigned>(frames), static_cast<unsigned>(replies),
+		static_cast<unsigned>(queries));
+	// The frames were held back until they fit, none of the changes is lost.
+	const std::vector<uint8_t> expected(BITMAP_BYTES, 0xFE);
+	EXPECT_TRUE(changed == expected);
+	// Only the replies beyond the backlog have been dropped.
+	if (queryStreamStats(stats, STREAM_STATS_RESET)) {
+		EXPECT_EQ(queries - replies, stats.messagesDropped);
+	}
+	setFeatures(0x00);
+	uncoverAll();
+}
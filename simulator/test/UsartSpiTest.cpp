@@ -0,0 +1,229 @@
+/*
+ * Sources of the human interface devices used by the battleship game.
+ *
+ * A project in collaboration with makerspace - Faculty of Computer Science
+ * at the Free University of Bozen-Bolzano.
+ *
+ *
+ *    m  a  k  e  r  s  p  a  c  e  .  i  n  f  .  u  n  i  b  z  .  i  t
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *                  8
+ *                  8
+ *   YoYoYo. .oPYo. 8  .o  .oPYo. YoYo. .oPYo. 8oPYo. .oPYo. .oPYo. .oPYo.
+ *   8' 8' 8 .oooo8 8oP'   8oooo8 8  `  Yb..`  8    8 .oooo8 8   `  8oooo8
+ *   8  8  8 8    8 8 `b.  8.  .  8      .'Yb. 8    8 8    8 8   .  8.  .
+ *   8  8  8 `YooP8 8  `o. `Yooo' 8     `YooP' 8YooP' `YooP8 `YooP' `Yooo'
+ *                                             8
+ *                                             8
+ *
+ *   8888888888888888888888888888888888888888888888888888888888888888888888
+ *
+ *    c  o  m  p  u  t  e  r    s  c  i  e  n  c  e    f  a  c  u  l  t  y
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Julian Sanin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "Mcp3008.h"
+#include "ShiftRegisterMatrix.h"
+#include "Simulator.h"
+#include "Test.h"
+
+// After the C++ library, as the core defines min() and max() as macros.
+#include <Arduino.h>
+#include "RgbLedMatrix.h"
+#include "RgbLedPhotodiodeArray.h"
+#include "SpiDevicePortB.h"
+#include "SpiDeviceUsart0.h"
+
+namespace {
+
+	enum {
+		PIN_SS_LED_MATRIX       = PB2,
+		F_SCK_LED_MATRIX        = 8000000,
+		PIN_SS_PHOTODIODE_ARRAY = PB1,
+		F_SCK_PHOTODIODE_ARRAY  = 2000000,
+		PIN_SS_SLOW             = PB0,
+		F_SCK_SLOW              = 3000000, // Not an even divider of F_CPU.
+		ROWS                    = 8,
+		COLUMN_REGISTERS        = 4,
+	};
+
+	typedef SpiDeviceUsart0<PIN_SS_LED_MATRIX, F_SCK_LED_MATRIX> MatrixBus;
+	typedef SpiDeviceUsart0<PIN_SS_SLOW, F_SCK_SLOW> SlowBus;
+	typedef RgbLedMatrix<MatrixBus> Matrix;
+	typedef RgbLedPhotodiodeArray<
+		SpiDevicePortB<PIN_SS_PHOTODIODE_ARRAY, F_SCK_PHOTODIODE_ARRAY>
+	> Photodiodes;
+
+	sim::ShiftRegisterMatrix matrix;
+	sim::ShiftRegisterMatrix slowMatrix;
+	sim::Mcp3008 adc;
+
+	uint16_t channelReading(uint8_t channel) {
+		return 0x080 * channel + 0x011;
+	}
+
+	/// <summary>
+	/// The LED matrix on USART0 and the photodiodes on the SPI, once per
+	/// test program.
+	/// </summary>
+	void begin() {
+		static bool isBegun = false;
+		if (isBegun) {
+			return;
+		}
+		isBegun = true;
+		sim::attachSpiSlave(matrix, PIN_SS_LED_MATRIX, sim::USART0_BUS);
+		sim::attachSpiSlave(slowMatrix, PIN_SS_SLOW, sim::USART0_BUS);
+		sim::attachSpiSlave(adc, PIN_SS_PHOTODIODE_ARRAY);
+		adc.setSource(channelReading);
+		Matrix::begin();
+		SlowBus::master();
+		Photodiodes::begin();
+		adc.clearConversions();
+	}
+
+	uint32_t cyclesToNanos(uint32_t cycles) {
+		return static_cast<uint32_t>(cycles * 1000000000ULL / F_CPU);
+	}
+
+	uint32_t transferBulkNanos(void (*transferBulk)(uint8_t *, uint8_t)) {
+		uint8_t data[COLUMN_REGISTERS] = { 0x01, 0x02, 0x03, 0x04 };
+		const uint64_t start = sim::nanos();
+		transferBulk(data, sizeof(data));
+		return static_cast<uint32_t>(sim::nanos() - start);
+	}
+}
+
+TEST(writesColumnsOnTheSecondBus) {
+	begin();
+	Matrix::writeColumn(0x81, 0x42, 0x24, 5);
+	EXPECT_TRUE(!matrix.latches().empty());
+	if (!matrix.latches().empty()) {
+		const sim::ShiftRegisterMatrix::Latch & latch = matrix.latches().back();
+		EXPECT_EQ(1 << 5, latch.columns);
+		EXPECT_EQ(0x81, latch.rows[sim::ShiftRegisterMatrix::RED]);
+		EXPECT_EQ(0x42, latch.rows[sim::ShiftRegisterMatrix::GREEN]);
+		EXPECT_EQ(0x24, latch.rows[sim::ShiftRegisterMatrix::BLUE]);
+	}
+	EXPECT_EQ(0u, adc.conversions().size());
+}
+
+TEST(receivesTheBytesShiftedOut) {
+	begin();
+	uint8_t first[COLUMN_REGISTERS] = { 0x10, 0x20, 0x30, 0x40 };
+	uint8_t second[COLUMN_REGISTERS] = { 0x50, 0x60, 0x70, 0x80 };
+	MatrixBus::transferBulk(first, sizeof(first));
+	MatrixBus::transferBulk(second, sizeof(second));
+	EXPECT_EQ(0x10, second[0]);
+	EXPECT_EQ(0x20, second[1]);
+	EXPECT_EQ(0x30, second[2]);
+	EXPECT_EQ(0x40, second[3]);
+}
+
+TEST(readsPhotodiodesWhileTheMatrixIsSelected) {
+	begin();
+	Matrix::writeColumn(0xFF, 0x00, 0x00, 2);
+	const size_t latches = matrix.latches().size();
+	PORTB &= ~(1 << PIN_SS_LED_MATRIX);
+	uint16_t readings[ROWS] = { 0 };
+	EXPECT_EQ(static_cast<uint8_t>(ROWS), Photodiodes::read(readings, ROWS));
+	PORTB |= (1 << PIN_SS_LED_MATRIX);
+	for (uint8_t i = 0; i < ROWS; i++) {
+		EXPECT_EQ(channelReading(i), readings[i]);
+	}
+	// None of the bytes on the SPI have been shifted into the matrix.
+	EXPECT_EQ(latches + 1, matrix.latches().size());
+	if (matrix.latches().size() == latches + 1) {
+		EXPECT_EQ(1 << 2, matrix.latches().back().columns);
+		EXPECT_EQ(0xFF, matrix.latches().back().rows[sim::ShiftRegisterMatrix::RED]);
+	}
+}
+
+TEST(shiftsAtTheConfiguredClock) {
+	begin();
+	// 8 MHz is F_CPU / 2, 3 MHz is rounded down to F_CPU / 6.
+	const uint32_t fastNanos = transferBulkNanos(MatrixBus::transferBulk);
+	const uint32_t slowNanos = transferBulkNanos(SlowBus::transferBulk);
+	printf("  4 bytes @ 8 MHz in %u ns, @ 3 MHz in %u ns\n",
+		static_cast<unsigned>(fastNanos), static_cast<unsigned>(slowNanos));
+	// Up to one iteration of the loop that polls the flags late.
+	const uint32_t pollNanos = cyclesToNanos(sim::UCSR0A_POLL_CYCLES);
+	EXPECT_NEAR(cyclesToNanos(
+		COLUMN_REGISTERS * 8 * 2 + sim::SPCR_TRANSACTION_CYCLES), fastNanos,
+		pollNanos);
+	EXPECT_NEAR(cyclesToNanos(
+		COLUMN_REGISTERS * 8 * 6 + sim::SPCR_TRANSACTION_CYCLES), slowNanos,
+		pollNanos);
+	EXPECT_TRUE(fastNanos <= MatrixBus::transferMicros(COLUMN_REGISTERS) * 1000);
+	EXPECT_TRUE(slowNanos <= SlowBus::transferMicros(COLUMN_REGISTERS) * 1000);
+}
+
+TEST(shiftsTheNextColumnWhileReadingPhotodiodes) {
+	begin();
+	uint64_t start = sim::nanos();
+	Matrix::writeColumn(0xFF, 0x00, 0x00, 2);
+	const uint64_t writeNanos = sim::nanos() - start;
+	uint16_t readings[ROWS] = { 0 };
+	start = sim::nanos();
+	Photodiodes::read(readings, ROWS);
+	const uint64_t readNanos = sim::nanos() - start;
+	const size_t latches = matrix.latches().size();
+	adc.clearConversions();
+	start = sim::nanos();
+	Matrix::shiftColumn(0x00, 0xFF, 0x00, 3);
+	EXPECT_EQ(static_cast<uint8_t>(ROWS),
+		Photodiodes::read(readings, ROWS, Matrix::continueColumn));
+	const uint64_t pipelinedNanos = sim::nanos() - start;
+	// Still the previous column is shown while the photodiodes are read.
+	EXPECT_EQ(latches, matrix.latches().size());
+	EXPECT_EQ(2, matrix.activeColumn());
+	for (uint8_t i = 0; i < ROWS; i++) {
+		EXPECT_EQ(channelReading(i), readings[i]);
+	}
+	start = sim::nanos();
+	Matrix::latchColumn();
+	const uint64_t latchNanos = sim::nanos() - start;
+	printf("  write %u ns and read %u ns, shift while reading %u ns and "
+		"latch %u ns\n",
+		static_cast<unsigned>(writeNanos), static_cast<unsigned>(readNanos),
+		static_cast<unsigned>(pipelinedNanos),
+		static_cast<unsigned>(latchNanos));
+	EXPECT_EQ(latches + 1, matrix.latches().size());
+	if (matrix.latches().size() == latches + 1) {
+		EXPECT_EQ(1 << 3, matrix.latches().back().columns);
+		EXPECT_EQ(0xFF, matrix.latches().back().rows[sim::ShiftRegisterMatrix::GREEN]);
+		EXPECT_EQ(0x00, matrix.latches().back().rows[sim::ShiftRegisterMatrix::RED]);
+	}
+	// The column has been shifted during the conversions, so it is latched
+	// at once and both take less time than one after the other.
+	EXPECT_TRUE(latchNanos < writeNanos / 4);
+	EXPECT_TRUE(pipelinedNanos + latchNanos < writeNanos + readNanos);
+	EXPECT_EQ(static_cast<size_t>(ROWS), adc.conversions().size());
+}